@@ -0,0 +1,77 @@
+#include "InfluenceIndex.h"
+
+#include <maya/MDagPathArray.h>
+#include <maya/MFnSkinCluster.h>
+
+InfluenceIndex::InfluenceIndex(const ValidateRigCmd::MayaSkeletonData& skeleton) :
+	m_skeleton(skeleton)
+{
+	unsigned int numJoints = skeleton.jointPaths.length();
+	m_jointByPath.reserve(numJoints);
+	m_depth.resize(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		m_jointByPath.emplace(skeleton.jointPaths[i].fullPathName().asChar(), static_cast<int>(i));
+
+		// Joints are in depth-first order, a parent always comes before its children
+		int parent = skeleton.jointParentIndices[i];
+		m_depth[i] = parent >= 0 ? m_depth[parent] + 1 : 0;
+	}
+}
+
+const InfluenceIndex::ClusterInfluences& InfluenceIndex::influences(const MObject& skinClusterNode)
+{
+	for (const auto& cluster : m_clusters) {
+		if (cluster.first == skinClusterNode) return cluster.second;
+	}
+
+	ClusterInfluences resolved;
+	MFnSkinCluster skinCluster(skinClusterNode);
+	MDagPathArray influencePaths;
+	unsigned int numInfluences = skinCluster.influenceObjects(influencePaths);
+
+	resolved.slotJoints.resize(numInfluences, -1);
+	bool allInSkeleton = numInfluences > 0;
+	for (unsigned int i = 0; i < numInfluences; ++i) {
+		auto it = m_jointByPath.find(influencePaths[i].fullPathName().asChar());
+		if (it != m_jointByPath.end()) {
+			resolved.slotJoints[i] = it->second;
+		}
+		else {
+			allInSkeleton = false;
+		}
+	}
+
+	if (allInSkeleton) {
+		resolved.commonRoot = resolved.slotJoints[0];
+		for (unsigned int i = 1; i < numInfluences && resolved.commonRoot >= 0; ++i) {
+			resolved.commonRoot = commonAncestor(resolved.commonRoot, resolved.slotJoints[i]);
+		}
+	}
+
+	ValidateRigCmd::readGeomBindTransform(skinClusterNode, resolved.geomBindTransform);
+
+	m_clusters.emplace_back(skinClusterNode, std::move(resolved));
+	return m_clusters.back().second;
+}
+
+void InfluenceIndex::forget(const MObject& skinClusterNode)
+{
+	for (auto it = m_clusters.begin(); it != m_clusters.end(); ++it) {
+		if (it->first == skinClusterNode) {
+			m_clusters.erase(it);
+			return;
+		}
+	}
+}
+
+int InfluenceIndex::commonAncestor(int a, int b) const
+{
+	const MIntArray& parents = m_skeleton.jointParentIndices;
+	while (a >= 0 && b >= 0 && m_depth[a] > m_depth[b]) a = parents[a];
+	while (a >= 0 && b >= 0 && m_depth[b] > m_depth[a]) b = parents[b];
+	while (a >= 0 && b >= 0 && a != b) {
+		a = parents[a];
+		b = parents[b];
+	}
+	return a >= 0 && b >= 0 ? a : -1;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <maya/MObject.h>
+#include <maya/MMatrix.h>
+
+// Skin cluster influences resolved against the joints of one extracted Maya skeleton.
+// The joint lookup and depths are built once per skeleton, and each skin cluster is
+// resolved the first time one of its meshes is parsed and then shared by the others.
+// Not thread safe, extraction runs on the main thread.
+class InfluenceIndex
+{
+public:
+	struct ClusterInfluences {
+		std::vector<int> slotJoints; // Skeleton joint of each influenceObjects() slot, -1 outside the skeleton
+		int commonRoot = -1;         // Lowest joint above every influence, -1 if one is outside the skeleton
+		MMatrix geomBindTransform;   // The skin cluster's geomMatrix
+	};
+
+	// skeleton must outlive the index
+	explicit InfluenceIndex(const ValidateRigCmd::MayaSkeletonData& skeleton);
+
+	// The reference stays valid while other skin clusters are resolved, until the cluster is forgotten
+	const ClusterInfluences& influences(const MObject& skinClusterNode);
+
+	// Drops what was resolved for a skin cluster, e.g. after its influences were edited
+	void forget(const MObject& skinClusterNode);
+
+	// Lowest common ancestor of two joints by walking parent indices, -1 for disjoint trees
+	int commonAncestor(int a, int b) const;
+
+	const ValidateRigCmd::MayaSkeletonData& skeleton() const { return m_skeleton; }
+
+private:
+	const ValidateRigCmd::MayaSkeletonData& m_skeleton;
+	std::unordered_map<std::string, int> m_jointByPath; // Full DAG path to joint index
+	std::vector<int> m_depth;
+
+	// A rig has a handful of skin clusters, a linear search beats hashing MObjects. A list so
+	// resolving one cluster does not move the others out from under references handed out.
+	std::list<std::pair<MObject, ClusterInfluences>> m_clusters;
+};
@@ -0,0 +1,73 @@
+#include "JointPathTable.h"
+
+#include <mutex>
+
+JointPathTable& JointPathTable::instance()
+{
+	static JointPathTable s_table;
+	return s_table;
+}
+
+void JointPathTable::intern(const std::vector<std::string>& paths, std::vector<int>& ids)
+{
+	size_t first = ids.size();
+	ids.resize(first + paths.size(), -1);
+
+	// Most paths are known after the first validation of a rig, look them up shared first
+	bool missing = false;
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		for (size_t i = 0; i < paths.size(); ++i) {
+			auto it = m_ids.find(paths[i]);
+			if (it != m_ids.end()) {
+				ids[first + i] = it->second;
+			}
+			else {
+				missing = true;
+			}
+		}
+	}
+	if (!missing) return;
+
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	for (size_t i = 0; i < paths.size(); ++i) {
+		if (ids[first + i] >= 0) continue;
+
+		auto inserted = m_ids.emplace(paths[i], static_cast<int>(m_paths.size()));
+		if (inserted.second) {
+			m_paths.push_back(&inserted.first->first);
+		}
+		ids[first + i] = inserted.first->second;
+	}
+}
+
+std::string JointPathTable::path(int id) const
+{
+	std::shared_lock<std::shared_mutex> lock(m_mutex);
+	if (id < 0 || id >= static_cast<int>(m_paths.size())) return std::string();
+	return *m_paths[id];
+}
+
+std::string JointPathTable::normalize(const std::string& path)
+{
+	std::string canonical;
+	canonical.reserve(path.size());
+
+	size_t begin = 0;
+	while (begin < path.size()) {
+		size_t end = path.find('/', begin);
+		if (end == std::string::npos) end = path.size();
+		if (end > begin) {
+			if (!canonical.empty()) canonical += '/';
+			canonical += stripNamespace(path.substr(begin, end - begin));
+		}
+		begin = end + 1;
+	}
+	return canonical;
+}
+
+std::string JointPathTable::stripNamespace(const std::string& name)
+{
+	size_t colon = name.rfind(':');
+	return colon == std::string::npos ? name : name.substr(colon + 1);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Process wide table of canonical joint paths, so the USD and Maya sides of a rig can be
+// compared by integer id instead of by string. A canonical path is relative to the
+// skeleton root, '/' separated and without namespaces: USD joint tokens are already
+// written that way, Maya joints are named by walking their parents from the root.
+//
+// Ids are never reused or released, the table only grows with the distinct joint paths
+// seen in the session. Interning takes a lock, so each adapter interns a whole skeleton
+// at once when it is parsed.
+class JointPathTable
+{
+public:
+	static JointPathTable& instance();
+
+	// Appends the id of every path, in order, adding the paths not seen before
+	void intern(const std::vector<std::string>& paths, std::vector<int>& ids);
+
+	// The canonical path of an id handed out by intern
+	std::string path(int id) const;
+
+	// Drops leading and trailing separators and the namespace of every component
+	static std::string normalize(const std::string& path);
+
+	// Name of one path component without its namespace
+	static std::string stripNamespace(const std::string& name);
+
+private:
+	mutable std::shared_mutex m_mutex;
+	std::unordered_map<std::string, int> m_ids;
+	std::vector<const std::string*> m_paths; // Keys of m_ids by id, map nodes never move
+};
@@ -0,0 +1,342 @@
+#include "ResultCache.h"
+#include "ValidationReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <system_error>
+#include <unistd.h>
+#include <pxr/usd/sdf/layer.h>
+#include <pxr/usd/sdf/layerUtils.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kEntryMagic[4] = { 'R', 'V', 'C', '1' };
+
+// Bytes this process stored per cache directory since it last scanned it, a directory
+// missing here has not been scanned yet
+std::mutex s_storedMutex;
+std::map<std::string, uint64_t> s_storedSinceTrim;
+
+uint64_t mix(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+// Streams a file into the hash without loading it whole, layers can be hundreds of megabytes
+bool hashFile(const std::string& path, ContentHash& hash)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open()) return false;
+
+	std::vector<char> buffer(1 << 20);
+	while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {
+		hash.add(buffer.data(), static_cast<size_t>(file.gcount()));
+	}
+	return true;
+}
+
+}
+
+void ContentHash::add(const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	m_length += size;
+
+	while (size >= 8) {
+		uint64_t word;
+		std::memcpy(&word, bytes, 8);
+		m_hash = (m_hash ^ mix(word)) * 0x9e3779b97f4a7c15ull;
+		bytes += 8;
+		size -= 8;
+	}
+
+	if (size > 0) {
+		uint64_t word = 0;
+		std::memcpy(&word, bytes, size);
+		m_hash = (m_hash ^ mix(word ^ (static_cast<uint64_t>(size) << 56))) * 0x9e3779b97f4a7c15ull;
+	}
+}
+
+void ContentHash::add(const MString& value)
+{
+	unsigned int length = value.length();
+	addValue(length);
+	add(value.asChar(), length);
+}
+
+uint64_t ContentHash::value() const
+{
+	return mix(m_hash ^ m_length);
+}
+
+std::string ContentHash::hex() const
+{
+	char text[17];
+	std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value()));
+	return text;
+}
+
+// Bound to a reference by ContentHash::addValue, so it needs a definition
+const uint32_t ResultCache::kVersion;
+
+ResultCache::ResultCache(const MString& directory, uint64_t maxBytes) :
+	m_directory(directory.asChar()), m_maxBytes(maxBytes)
+{
+}
+
+std::string ResultCache::key(const MString& usdFilePath, const ValidateRigCmd::MayaRigData& mayaRig,
+	const std::vector<double>& settings, const std::string& usdSkeleton) const
+{
+	std::string layerHash = hashLayerStack(usdFilePath);
+	if (layerHash.empty()) return std::string();
+
+	ContentHash hash;
+	hash.addValue(kVersion);
+	hash.add(layerHash.data(), layerHash.size());
+	hashMayaRig(mayaRig, hash);
+	for (double setting : settings) {
+		hash.addValue(setting);
+	}
+	if (!usdSkeleton.empty()) {
+		hash.add(usdSkeleton.data(), usdSkeleton.size());
+	}
+	return hash.hex();
+}
+
+bool ResultCache::lookup(const std::string& key, BoundedIssueSink& issues) const
+{
+	if (key.empty()) return false;
+
+	std::string path = entryPath(key);
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open()) return false;
+
+	char magic[sizeof(kEntryMagic)];
+	uint32_t version = 0;
+	uint64_t payloadSize = 0;
+	uint64_t checksum = 0;
+	if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, kEntryMagic, sizeof(magic)) != 0 ||
+		!file.read(reinterpret_cast<char*>(&version), sizeof(version)) || version != kVersion ||
+		!file.read(reinterpret_cast<char*>(&payloadSize), sizeof(payloadSize)) ||
+		!file.read(reinterpret_cast<char*>(&checksum), sizeof(checksum)) ||
+		payloadSize > m_maxBytes) {
+		return false;
+	}
+
+	std::string payload(payloadSize, '\0');
+	if (!file.read(&payload[0], payloadSize)) return false;
+
+	ContentHash payloadHash;
+	payloadHash.add(payload.data(), payload.size());
+	if (payloadHash.value() != checksum) return false;
+
+	BoundedIssueSink cached(issues.sampleLimit());
+	if (!cached.deserialize(payload)) return false;
+	issues = cached;
+
+	// Recently used entries are the last to be evicted
+	std::error_code error;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+
+	return true;
+}
+
+bool ResultCache::store(const std::string& key, const BoundedIssueSink& issues) const
+{
+	if (key.empty()) return false;
+
+	std::string payload;
+	issues.serialize(payload);
+
+	ContentHash payloadHash;
+	payloadHash.add(payload.data(), payload.size());
+	uint32_t version = kVersion;
+	uint64_t payloadSize = payload.size();
+	uint64_t checksum = payloadHash.value();
+
+	std::string path = entryPath(key);
+	std::error_code error;
+	fs::create_directories(fs::path(path).parent_path(), error);
+
+	// Unique per process and call, the rename below publishes the entry atomically
+	static std::atomic<unsigned int> s_counter(0);
+	std::string tmpPath = path + "." + std::to_string(getpid()) + "." + std::to_string(s_counter++) + ".tmp";
+	{
+		std::ofstream file(tmpPath, std::ios::out | std::ios::trunc | std::ios::binary);
+		file.write(kEntryMagic, sizeof(kEntryMagic));
+		file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+		file.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+		file.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+		file.write(payload.data(), payload.size());
+		if (!file) {
+			fs::remove(tmpPath, error);
+			return false;
+		}
+	}
+
+	fs::rename(tmpPath, path, error);
+	if (error) {
+		fs::remove(tmpPath, error);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(s_storedMutex);
+	auto stored = s_storedSinceTrim.find(m_directory);
+	if (stored != s_storedSinceTrim.end()) {
+		stored->second += sizeof(kEntryMagic) + sizeof(version) + sizeof(payloadSize) + sizeof(checksum) + payloadSize;
+	}
+	return true;
+}
+
+void ResultCache::trim() const
+{
+	struct CachedFile {
+		fs::path path;
+		fs::file_time_type lastUsed;
+		uint64_t size;
+	};
+
+	std::vector<CachedFile> files;
+	uint64_t totalBytes = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(s_storedMutex);
+		s_storedSinceTrim[m_directory] = 0;
+	}
+
+	std::error_code error;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(m_directory, error)) {
+		if (!entry.is_regular_file(error) || entry.path().extension() != ".rvc") continue;
+
+		CachedFile file = { entry.path(), entry.last_write_time(error), entry.file_size(error) };
+		totalBytes += file.size;
+		files.push_back(file);
+	}
+	if (totalBytes <= m_maxBytes) return;
+
+	// Down to 90% so that every store does not trigger another scan
+	std::sort(files.begin(), files.end(),
+		[](const CachedFile& a, const CachedFile& b) { return a.lastUsed < b.lastUsed; });
+	uint64_t target = m_maxBytes / 10 * 9;
+	for (const CachedFile& file : files) {
+		if (totalBytes <= target) break;
+		// Readers that already opened the entry keep reading the unlinked file
+		if (fs::remove(file.path, error)) {
+			totalBytes -= file.size;
+		}
+	}
+}
+
+void ResultCache::trimIfDue() const
+{
+	// trim() leaves a tenth of the budget free, so the cache cannot be over it again before
+	// that much has been stored. Other processes sharing the directory count their own stores.
+	{
+		std::lock_guard<std::mutex> lock(s_storedMutex);
+		auto stored = s_storedSinceTrim.find(m_directory);
+		if (stored != s_storedSinceTrim.end() && stored->second < m_maxBytes / 10) return;
+	}
+	trim();
+}
+
+std::string ResultCache::hashLayerStack(const MString& usdFilePath)
+{
+	// Walks the layers the stage would be composed from without composing it. Every asset a
+	// layer names is followed, including payloads a stage opened with LoadNone would skip.
+	SdfLayerRefPtr rootLayer = SdfLayer::FindOrOpen(usdFilePath.asChar());
+	if (!rootLayer) return std::string();
+
+	std::vector<SdfLayerRefPtr> layers(1, rootLayer);
+	std::set<std::string> visited;
+	visited.insert(rootLayer->GetIdentifier());
+	for (size_t i = 0; i < layers.size(); ++i) {
+		SdfLayerRefPtr layer = layers[i];
+		for (const std::string& assetPath : layer->GetCompositionAssetDependencies()) {
+			std::string resolved = SdfComputeAssetPathRelativeToLayer(layer, assetPath);
+			if (resolved.empty()) continue;
+
+			// A missing layer is left out, it changes the hash once it appears
+			SdfLayerRefPtr dependency = SdfLayer::FindOrOpen(resolved);
+			if (!dependency || !visited.insert(dependency->GetIdentifier()).second) continue;
+			layers.push_back(dependency);
+		}
+	}
+
+	// Hashed per layer and combined in sorted order, the walk order is not part of the content
+	std::vector<uint64_t> layerHashes;
+	for (const SdfLayerRefPtr& layer : layers) {
+		ContentHash layerHash;
+		std::string realPath = layer->GetRealPath();
+		if (layer->IsAnonymous() || layer->IsDirty() || realPath.empty() || !hashFile(realPath, layerHash)) {
+			// Anonymous identifiers change every session, only their contents count
+			std::string text;
+			layer->ExportToString(&text);
+			layerHash = ContentHash();
+			layerHash.add(text.data(), text.size());
+		}
+		if (!layer->IsAnonymous()) {
+			const std::string& identifier = layer->GetIdentifier();
+			layerHash.add(identifier.data(), identifier.size());
+		}
+		layerHashes.push_back(layerHash.value());
+	}
+	std::sort(layerHashes.begin(), layerHashes.end());
+
+	ContentHash hash;
+	hash.add(layerHashes.data(), layerHashes.size() * sizeof(uint64_t));
+	return hash.hex();
+}
+
+void ResultCache::hashMayaRig(const ValidateRigCmd::MayaRigData& mayaRig, ContentHash& hash)
+{
+	const ValidateRigCmd::MayaSkeletonData& skel = mayaRig.skeleton;
+	unsigned int numJoints = skel.jointNames.length();
+	hash.addValue(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		hash.add(skel.jointNames[i]);
+		hash.addValue(skel.jointParentIndices[i]);
+		hash.addValue(skel.bindTransforms[i].matrix);
+		hash.addValue(skel.restTransforms[i].matrix);
+	}
+
+	unsigned int numSkins = static_cast<unsigned int>(mayaRig.skinBindings.size());
+	hash.addValue(numSkins);
+	for (unsigned int s = 0; s < numSkins; ++s) {
+		const ValidateRigCmd::MayaSkinBindingData& skin = mayaRig.skinBindings[s];
+		hash.add(mayaRig.geomNames[s]);
+		hash.addValue(skin.geomBindTransform.matrix);
+
+		unsigned int numOffsets = skin.vertexOffsets.length();
+		hash.addValue(numOffsets);
+		for (unsigned int i = 0; i < numOffsets; ++i) {
+			hash.addValue(skin.vertexOffsets[i]);
+		}
+
+		unsigned int numInfluences = skin.jointIndices.length();
+		hash.addValue(numInfluences);
+		for (unsigned int i = 0; i < numInfluences; ++i) {
+			hash.addValue(skin.jointIndices[i]);
+			hash.addValue(skin.jointWeights[i]);
+		}
+	}
+}
+
+std::string ResultCache::entryPath(const std::string& key) const
+{
+	// Fanned out over 256 directories to keep them small
+	return m_directory + "/" + key.substr(0, 2) + "/" + key + ".rvc";
+}
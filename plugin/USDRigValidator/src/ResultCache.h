@@ -0,0 +1,71 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <maya/MString.h>
+
+class BoundedIssueSink;
+
+// Streaming 64-bit content hash, processes eight bytes at a time
+class ContentHash
+{
+public:
+	void add(const void* data, size_t size);
+	void add(const MString& value);
+
+	template <typename T>
+	void addValue(const T& value) { add(&value, sizeof(value)); }
+
+	uint64_t value() const;
+	std::string hex() const;
+
+private:
+	uint64_t m_hash = 0x9e3779b97f4a7c15ull;
+	uint64_t m_length = 0;
+};
+
+// On-disk cache of validation results, shared by every Maya session and farm worker on
+// the machine. An entry is keyed by everything the result depends on: the contents of
+// the USD layers the stage uses, the extracted Maya rig, the validation settings and
+// kVersion, which must be bumped whenever the checks change what they report.
+//
+// Entries are written to a temporary file and renamed into place, so readers never need
+// a lock: they either find a complete entry or none. A hit touches the entry's
+// modification time, and trim() evicts the least recently used entries over the budget.
+class ResultCache
+{
+public:
+	static const uint32_t kVersion = 7;
+
+	explicit ResultCache(const MString& directory, uint64_t maxBytes = 256ull << 20);
+
+	// Settings are the tolerances and options the result depends on, as numbers. usdSkeleton
+	// is the prim path of the skeleton compared when it was chosen by path, not by root name.
+	std::string key(const MString& usdFilePath, const ValidateRigCmd::MayaRigData& mayaRig,
+		const std::vector<double>& settings, const std::string& usdSkeleton = std::string()) const;
+
+	// Fills issues, which must have the sample limit the entry was stored with
+	bool lookup(const std::string& key, BoundedIssueSink& issues) const;
+	bool store(const std::string& key, const BoundedIssueSink& issues) const;
+
+	// Evicts least recently used entries until the cache fits in its budget
+	void trim() const;
+
+	// trim() once this process has stored enough since its last scan of the directory to
+	// have pushed the cache over the budget, so a store per command does not rescan it
+	void trimIfDue() const;
+
+	// Hash of every layer usdFilePath is composed from, following sublayers, references and
+	// payloads through the layers alone. Empty if the root layer cannot be opened.
+	static std::string hashLayerStack(const MString& usdFilePath);
+	static void hashMayaRig(const ValidateRigCmd::MayaRigData& mayaRig, ContentHash& hash);
+
+private:
+	std::string m_directory;
+	uint64_t m_maxBytes;
+
+	std::string entryPath(const std::string& key) const;
+};
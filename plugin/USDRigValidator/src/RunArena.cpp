@@ -0,0 +1,28 @@
+#include "RunArena.h"
+
+namespace {
+
+thread_local std::pmr::memory_resource* t_resource = nullptr;
+
+}
+
+RunArena::RunArena(size_t initialBytes) :
+	m_resource(initialBytes, std::pmr::new_delete_resource())
+{
+}
+
+std::pmr::memory_resource* RunArena::current()
+{
+	return t_resource ? t_resource : std::pmr::get_default_resource();
+}
+
+RunArena::Scope::Scope(RunArena& arena) :
+	m_previous(t_resource)
+{
+	t_resource = arena.resource();
+}
+
+RunArena::Scope::~Scope()
+{
+	t_resource = m_previous;
+}
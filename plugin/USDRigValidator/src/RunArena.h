@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+// Scratch memory for one validation run. The extraction and validation code takes its
+// transient buffers (traversal stacks, frame lists, per chunk results) from
+// RunArena::current(), which bumps a pointer instead of going through the heap, and
+// everything is released at once when the arena is destroyed. Nothing allocated from
+// an arena may outlive it, so results handed back to callers still use plain containers.
+//
+// An arena is not thread safe. A Scope installs it for the calling thread only, other
+// threads keep using the heap unless they install an arena of their own.
+class RunArena
+{
+public:
+	explicit RunArena(size_t initialBytes = 64 * 1024);
+
+	RunArena(const RunArena&) = delete;
+	RunArena& operator=(const RunArena&) = delete;
+
+	std::pmr::memory_resource* resource() { return &m_resource; }
+
+	// The arena installed on this thread, or the default heap resource
+	static std::pmr::memory_resource* current();
+
+	// Makes arena current on this thread for the lifetime of the scope
+	class Scope {
+	public:
+		explicit Scope(RunArena& arena);
+		~Scope();
+
+	private:
+		std::pmr::memory_resource* m_previous;
+	};
+
+private:
+	std::pmr::monotonic_buffer_resource m_resource;
+};
@@ -0,0 +1,127 @@
+#include "SceneCache.h"
+
+#include <maya/MStatus.h>
+#include <maya/MMessage.h>
+#include <maya/MSceneMessage.h>
+#include <maya/MDGMessage.h>
+#include <maya/MNodeMessage.h>
+
+std::unique_ptr<SceneCache> SceneCache::s_instance;
+
+void SceneCache::create()
+{
+	s_instance.reset(new SceneCache());
+}
+
+void SceneCache::destroy()
+{
+	s_instance.reset();
+}
+
+SceneCache* SceneCache::instance()
+{
+	return s_instance.get();
+}
+
+SceneCache::SceneCache() :
+	m_skinClustersStale(true)
+{
+	MStatus status;
+	auto track = [this, &status](MCallbackId id) {
+		if (status == MS::kSuccess) m_callbackIds.append(id);
+	};
+
+	const MSceneMessage::Message sceneMessages[] = { MSceneMessage::kBeforeNew, MSceneMessage::kBeforeOpen };
+	for (MSceneMessage::Message msg : sceneMessages) {
+		track(MSceneMessage::addCallback(msg, onSceneChanged, this, &status));
+	}
+
+	const char* nodeTypes[] = { "joint", "skinCluster" };
+	for (const char* nodeType : nodeTypes) {
+		track(MDGMessage::addNodeAddedCallback(onNodeChanged, nodeType, this, &status));
+		track(MDGMessage::addNodeRemovedCallback(onNodeChanged, nodeType, this, &status));
+	}
+
+	// A null node watches every node, renames and reparenting change the cached paths
+	MObject allNodes;
+	track(MNodeMessage::addNameChangedCallback(allNodes, onNameChanged, this, &status));
+	track(MDagMessage::addAllDagChangesCallback(onDagChanged, this, &status));
+
+	// Influences and bound meshes are connections to the skin cluster
+	track(MDGMessage::addConnectionCallback(onConnectionChanged, this, &status));
+}
+
+SceneCache::~SceneCache()
+{
+	for (unsigned int i = 0; i < m_callbackIds.length(); ++i) {
+		MMessage::removeCallback(m_callbackIds[i]);
+	}
+}
+
+const SkinClusterIndex& SceneCache::skinClusters()
+{
+	if (m_skinClustersStale) {
+		m_skinClusters.build();
+		m_skinClustersStale = false;
+	}
+	return m_skinClusters;
+}
+
+bool SceneCache::findJointHierarchy(const MDagPath& root, ValidateRigCmd::MayaSkeletonData& skelData) const
+{
+	auto it = m_hierarchies.find(root.fullPathName().asChar());
+	if (it == m_hierarchies.end()) return false;
+
+	const ValidateRigCmd::MayaSkeletonData& cached = it->second;
+	skelData.rootPath = cached.rootPath;
+	skelData.jointPaths = cached.jointPaths;
+	skelData.jointNames = cached.jointNames;
+	skelData.jointIds = cached.jointIds;
+	skelData.jointParentIndices = cached.jointParentIndices;
+	return true;
+}
+
+void SceneCache::storeJointHierarchy(const MDagPath& root, const ValidateRigCmd::MayaSkeletonData& skelData)
+{
+	ValidateRigCmd::MayaSkeletonData& cached = m_hierarchies[root.fullPathName().asChar()];
+	cached.rootPath = skelData.rootPath;
+	cached.jointPaths = skelData.jointPaths;
+	cached.jointNames = skelData.jointNames;
+	cached.jointIds = skelData.jointIds;
+	cached.jointParentIndices = skelData.jointParentIndices;
+}
+
+void SceneCache::invalidate()
+{
+	m_skinClustersStale = true;
+	m_hierarchies.clear();
+}
+
+void SceneCache::onSceneChanged(void* clientData)
+{
+	static_cast<SceneCache*>(clientData)->invalidate();
+}
+
+void SceneCache::onNodeChanged(MObject& node, void* clientData)
+{
+	static_cast<SceneCache*>(clientData)->invalidate();
+}
+
+void SceneCache::onNameChanged(MObject& node, const MString& previousName, void* clientData)
+{
+	if (!node.hasFn(MFn::kDagNode) && !node.hasFn(MFn::kSkinClusterFilter)) return;
+	static_cast<SceneCache*>(clientData)->invalidate();
+}
+
+void SceneCache::onDagChanged(MDagMessage::DagMessage msg, MDagPath& child, MDagPath& parent, void* clientData)
+{
+	static_cast<SceneCache*>(clientData)->invalidate();
+}
+
+void SceneCache::onConnectionChanged(MPlug& source, MPlug& destination, bool made, void* clientData)
+{
+	// Only the skin cluster index depends on connections, the hierarchies stay valid
+	if (source.node().hasFn(MFn::kSkinClusterFilter) || destination.node().hasFn(MFn::kSkinClusterFilter)) {
+		static_cast<SceneCache*>(clientData)->m_skinClustersStale = true;
+	}
+}
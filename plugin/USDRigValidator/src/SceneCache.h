@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+#include "SkinClusterIndex.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <maya/MDagPath.h>
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MString.h>
+#include <maya/MCallbackIdArray.h>
+#include <maya/MDagMessage.h>
+
+// Scene topology kept from one validateRig call to the next for the lifetime of the
+// plugin: the skin cluster index and the joint hierarchy under every root extracted so
+// far. Scene new and open, joints and skin clusters added or removed, skin cluster
+// connections, renames and reparenting mark it stale, and the next lookup rebuilds it.
+//
+// Transforms are not kept, editing one sends none of those messages. They are read from
+// the scene on every call, bind transforms through the bindPreMatrix plugs the index
+// located instead of a scan of every skin cluster per joint.
+//
+// Main thread only, like the Maya API it wraps.
+class SceneCache
+{
+public:
+	// Called from initializePlugin and uninitializePlugin
+	static void create();
+	static void destroy();
+
+	// Lives as long as the plugin is loaded, so it is there for every command
+	static SceneCache* instance();
+
+	const SkinClusterIndex& skinClusters();
+
+	// Fills the hierarchy fields of skelData as parseMayaJointHierarchy extracted them for
+	// root, false when root has not been extracted since the last change
+	bool findJointHierarchy(const MDagPath& root, ValidateRigCmd::MayaSkeletonData& skelData) const;
+	void storeJointHierarchy(const MDagPath& root, const ValidateRigCmd::MayaSkeletonData& skelData);
+
+	void invalidate();
+
+	~SceneCache();
+
+private:
+	SceneCache();
+
+	SkinClusterIndex m_skinClusters;
+	bool m_skinClustersStale;
+	std::map<std::string, ValidateRigCmd::MayaSkeletonData> m_hierarchies; // By full DAG path of the root
+
+	MCallbackIdArray m_callbackIds;
+
+	static std::unique_ptr<SceneCache> s_instance;
+
+	static void onSceneChanged(void* clientData);
+	static void onNodeChanged(MObject& node, void* clientData);
+	static void onNameChanged(MObject& node, const MString& previousName, void* clientData);
+	static void onDagChanged(MDagMessage::DagMessage msg, MDagPath& child, MDagPath& parent, void* clientData);
+	static void onConnectionChanged(MPlug& source, MPlug& destination, bool made, void* clientData);
+};
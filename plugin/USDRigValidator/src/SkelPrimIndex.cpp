@@ -0,0 +1,81 @@
+#include "SkelPrimIndex.h"
+
+#include <algorithm>
+#include <pxr/usd/usd/prim.h>
+#include <pxr/usd/usd/primRange.h>
+#include <pxr/usd/usdGeom/gprim.h>
+#include <pxr/usd/usdSkel/skeleton.h>
+#include <pxr/usd/usdSkel/bindingAPI.h>
+#include <pxr/base/work/loops.h>
+#include <pxr/base/work/threadLimits.h>
+
+namespace {
+
+// A few subtrees per thread keeps the load balanced when one character dwarfs the props
+const unsigned int kSubtreesPerThread = 4;
+const int kMaxSplitDepth = 4;
+
+struct Found {
+	std::vector<SdfPath> skeletons;
+	std::vector<SdfPath> boundPrims;
+};
+
+// False when nothing below prim can hold skel data
+bool visit(const UsdPrim& prim, Found& found)
+{
+	if (prim.IsA<UsdSkelSkeleton>()) {
+		found.skeletons.push_back(prim.GetPath());
+	}
+	if (prim.HasAPI<UsdSkelBindingAPI>()) {
+		found.boundPrims.push_back(prim.GetPath());
+	}
+	return !prim.IsA<UsdGeomGprim>();
+}
+
+}
+
+void SkelPrimIndex::build(const UsdStageRefPtr& stage)
+{
+	m_skeletons.clear();
+	m_boundPrims.clear();
+	if (!stage) return;
+
+	// Split level by level until there is enough work for every thread. The prims above
+	// the split are visited here, each prim on the final level roots one parallel walk.
+	Found top;
+	std::vector<UsdPrim> subtrees;
+	for (const UsdPrim& child : stage->GetPseudoRoot().GetFilteredChildren(UsdPrimDefaultPredicate)) {
+		subtrees.push_back(child);
+	}
+	size_t targetSubtrees = kSubtreesPerThread * WorkGetConcurrencyLimit();
+	for (int depth = 0; depth < kMaxSplitDepth && !subtrees.empty() && subtrees.size() < targetSubtrees; ++depth) {
+		std::vector<UsdPrim> next;
+		for (const UsdPrim& prim : subtrees) {
+			if (!visit(prim, top)) continue;
+			for (const UsdPrim& child : prim.GetFilteredChildren(UsdPrimDefaultPredicate)) {
+				next.push_back(child);
+			}
+		}
+		subtrees.swap(next);
+	}
+
+	// Reads only, each walk fills its own slot
+	std::vector<Found> found(subtrees.size());
+	WorkParallelForN(subtrees.size(), [&subtrees, &found](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			UsdPrimRange range(subtrees[i], UsdPrimDefaultPredicate);
+			for (auto it = range.begin(); it != range.end(); ++it) {
+				if (!visit(*it, found[i])) it.PruneChildren();
+			}
+		}
+	});
+
+	m_skeletons = std::move(top.skeletons);
+	m_boundPrims = std::move(top.boundPrims);
+	for (Found& subtree : found) {
+		m_skeletons.insert(m_skeletons.end(), subtree.skeletons.begin(), subtree.skeletons.end());
+		m_boundPrims.insert(m_boundPrims.end(), subtree.boundPrims.begin(), subtree.boundPrims.end());
+	}
+	std::sort(m_skeletons.begin(), m_skeletons.end());
+	std::sort(m_boundPrims.begin(), m_boundPrims.end());
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include <pxr/pxr.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/sdf/path.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// Every skeleton and every prim with skel bindings on a stage, gathered in one pass. The
+// prim tree is split a few levels below the pseudo-root and the subtrees are walked in
+// parallel with the default predicate, so discovery on large set dressing stages no longer
+// runs on a single thread. Gprims end their subtree: UsdGeom does not allow them to nest,
+// so nothing below one can be a skeleton or skinned geometry.
+class SkelPrimIndex
+{
+public:
+	void build(const UsdStageRefPtr& stage);
+
+	// Sorted by path, the same from one run to the next whatever the thread timing
+	const std::vector<SdfPath>& skeletons() const { return m_skeletons; }
+
+	// Prims with UsdSkelBindingAPI applied, bound to whichever skeleton they inherit
+	const std::vector<SdfPath>& boundPrims() const { return m_boundPrims; }
+
+private:
+	std::vector<SdfPath> m_skeletons;
+	std::vector<SdfPath> m_boundPrims;
+};
@@ -0,0 +1,269 @@
+#include "SkeletonMatcher.h"
+#include "ResultCache.h"
+#include "JointPathTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <maya/MFnDagNode.h>
+
+namespace {
+
+// Weight of a label mismatch, below one differing joint so structure decides first
+const double kLabelDistance = 0.5;
+
+// Farthest a pair may be apart, relative to the larger skeleton. Every renamed joint
+// counts twice, so this allows about a quarter of the joints to differ.
+const double kMaxDistanceFraction = 0.5;
+
+std::string lastComponent(const std::string& path, char separator)
+{
+	size_t split = path.rfind(separator);
+	return split == std::string::npos ? path : path.substr(split + 1);
+}
+
+}
+
+uint64_t SkeletonMatcher::Signature::key() const
+{
+	ContentHash hash;
+	hash.addValue(jointCount);
+	hash.add(depthHistogram.data(), depthHistogram.size() * sizeof(unsigned int));
+	hash.addValue(nameHash);
+	return hash.value();
+}
+
+SkeletonMatcher::Signature SkeletonMatcher::signature(const ValidateRigCmd::USDSkeletonData& skeleton)
+{
+	// Copies of a character usually differ in the prim above the skeleton
+	std::string label = lastComponent(skeleton.primPath.GetParentPath().GetString(), '/');
+	std::vector<int> parentIndices(skeleton.jointParentIndices.begin(), skeleton.jointParentIndices.end());
+	return signature(skeleton.jointIds, parentIndices, label);
+}
+
+SkeletonMatcher::Signature SkeletonMatcher::signature(const ValidateRigCmd::MayaSkeletonData& skeleton,
+	const MDagPath& root)
+{
+	// The namespace a referenced character was brought in under, otherwise the node above the root
+	std::string rootName = MFnDagNode(root).name().asChar();
+	size_t split = rootName.rfind(':');
+	std::string label;
+	if (split != std::string::npos) {
+		label = lastComponent(rootName.substr(0, split), ':');
+	}
+	else {
+		MDagPath parent = root;
+		parent.pop();
+		if (parent.length() > 0) {
+			label = JointPathTable::stripNamespace(MFnDagNode(parent).name().asChar());
+		}
+	}
+
+	std::vector<int> parentIndices(skeleton.jointParentIndices.length());
+	for (unsigned int i = 0; i < skeleton.jointParentIndices.length(); ++i) {
+		parentIndices[i] = skeleton.jointParentIndices[i];
+	}
+	return signature(skeleton.jointIds, parentIndices, label);
+}
+
+SkeletonMatcher::Signature SkeletonMatcher::signature(const std::vector<int>& jointIds,
+	const std::vector<int>& parentIndices, const std::string& label)
+{
+	Signature result;
+	result.jointCount = static_cast<unsigned int>(parentIndices.size());
+	result.label = label;
+
+	// Parents come before their children on both sides
+	std::vector<unsigned int> depths(parentIndices.size(), 0);
+	for (size_t i = 0; i < parentIndices.size(); ++i) {
+		int parent = parentIndices[i];
+		depths[i] = parent >= 0 && static_cast<size_t>(parent) < i ? depths[parent] + 1 : 0;
+		if (depths[i] >= result.depthHistogram.size()) {
+			result.depthHistogram.resize(depths[i] + 1, 0);
+		}
+		result.depthHistogram[depths[i]]++;
+	}
+
+	result.sortedJointIds = jointIds;
+	std::sort(result.sortedJointIds.begin(), result.sortedJointIds.end());
+	ContentHash hash;
+	hash.add(result.sortedJointIds.data(), result.sortedJointIds.size() * sizeof(int));
+	result.nameHash = hash.value();
+
+	return result;
+}
+
+double SkeletonMatcher::distance(const Signature& a, const Signature& b)
+{
+	double result = std::abs(static_cast<double>(a.jointCount) - static_cast<double>(b.jointCount));
+
+	size_t numDepths = std::max(a.depthHistogram.size(), b.depthHistogram.size());
+	for (size_t d = 0; d < numDepths; ++d) {
+		unsigned int countA = d < a.depthHistogram.size() ? a.depthHistogram[d] : 0;
+		unsigned int countB = d < b.depthHistogram.size() ? b.depthHistogram[d] : 0;
+		result += std::abs(static_cast<double>(countA) - static_cast<double>(countB));
+	}
+
+	// Joints named on one side only
+	if (a.nameHash != b.nameHash) {
+		size_t i = 0, j = 0, common = 0;
+		while (i < a.sortedJointIds.size() && j < b.sortedJointIds.size()) {
+			if (a.sortedJointIds[i] < b.sortedJointIds[j]) ++i;
+			else if (b.sortedJointIds[j] < a.sortedJointIds[i]) ++j;
+			else { ++common; ++i; ++j; }
+		}
+		result += static_cast<double>(a.sortedJointIds.size() + b.sortedJointIds.size() - 2 * common);
+	}
+
+	if (a.label != b.label) result += kLabelDistance;
+	return result;
+}
+
+bool SkeletonMatcher::pairable(const Signature& a, const Signature& b)
+{
+	return distance(a, b) <= kMaxDistanceFraction * std::max(a.jointCount, b.jointCount);
+}
+
+std::vector<std::pair<int, int>> SkeletonMatcher::match(const std::vector<Signature>& usd,
+	const std::vector<Signature>& maya)
+{
+	std::vector<std::pair<int, int>> pairs;
+	std::vector<char> usdMatched(usd.size(), 0), mayaMatched(maya.size(), 0);
+
+	// Buckets holding exactly one skeleton from each side pair up without further work
+	struct Bucket {
+		int usdCount = 0, mayaCount = 0;
+		int usdIndex = -1, mayaIndex = -1;
+	};
+	std::unordered_map<uint64_t, Bucket> buckets;
+	for (size_t i = 0; i < usd.size(); ++i) {
+		Bucket& bucket = buckets[usd[i].key()];
+		bucket.usdCount++;
+		bucket.usdIndex = static_cast<int>(i);
+	}
+	for (size_t i = 0; i < maya.size(); ++i) {
+		Bucket& bucket = buckets[maya[i].key()];
+		bucket.mayaCount++;
+		bucket.mayaIndex = static_cast<int>(i);
+	}
+	for (const auto& entry : buckets) {
+		const Bucket& bucket = entry.second;
+		if (bucket.usdCount == 1 && bucket.mayaCount == 1) {
+			pairs.emplace_back(bucket.usdIndex, bucket.mayaIndex);
+			usdMatched[bucket.usdIndex] = 1;
+			mayaMatched[bucket.mayaIndex] = 1;
+		}
+	}
+
+	// Ambiguous and unmatched ones by minimum total distance
+	std::vector<int> usdLeft, mayaLeft;
+	for (size_t i = 0; i < usd.size(); ++i) {
+		if (!usdMatched[i]) usdLeft.push_back(static_cast<int>(i));
+	}
+	for (size_t i = 0; i < maya.size(); ++i) {
+		if (!mayaMatched[i]) mayaLeft.push_back(static_cast<int>(i));
+	}
+
+	if (!usdLeft.empty() && !mayaLeft.empty()) {
+		// Rows are the smaller side
+		bool usdRows = usdLeft.size() <= mayaLeft.size();
+		const std::vector<int>& rows = usdRows ? usdLeft : mayaLeft;
+		const std::vector<int>& columns = usdRows ? mayaLeft : usdLeft;
+
+		// Unpairable cells cost more than all pairable ones together, so the assignment
+		// only falls back on them when nothing else is left for a row
+		std::vector<std::vector<double>> cost(rows.size(), std::vector<double>(columns.size()));
+		std::vector<std::vector<char>> rejected(rows.size(), std::vector<char>(columns.size(), 0));
+		double rejectedCost = 1.0;
+		for (size_t r = 0; r < rows.size(); ++r) {
+			for (size_t c = 0; c < columns.size(); ++c) {
+				const Signature& usdSignature = usd[usdRows ? rows[r] : columns[c]];
+				const Signature& mayaSignature = maya[usdRows ? columns[c] : rows[r]];
+				cost[r][c] = distance(usdSignature, mayaSignature);
+				rejected[r][c] = !pairable(usdSignature, mayaSignature);
+				if (!rejected[r][c]) rejectedCost += cost[r][c];
+			}
+		}
+		for (size_t r = 0; r < rows.size(); ++r) {
+			for (size_t c = 0; c < columns.size(); ++c) {
+				if (rejected[r][c]) cost[r][c] = rejectedCost;
+			}
+		}
+
+		std::vector<int> assignment = assign(cost);
+		for (size_t r = 0; r < rows.size(); ++r) {
+			if (assignment[r] < 0 || rejected[r][assignment[r]]) continue;
+			int column = columns[assignment[r]];
+			pairs.emplace_back(usdRows ? rows[r] : column, usdRows ? column : rows[r]);
+		}
+	}
+
+	std::sort(pairs.begin(), pairs.end());
+	return pairs;
+}
+
+std::vector<int> SkeletonMatcher::assign(const std::vector<std::vector<double>>& cost)
+{
+	// Shortest augmenting paths with row and column potentials, O(rows^2 * columns)
+	size_t numRows = cost.size();
+	size_t numColumns = numRows > 0 ? cost[0].size() : 0;
+	const double kInfinity = std::numeric_limits<double>::infinity();
+
+	// 1-based, column 0 is the virtual start of each augmenting path
+	std::vector<double> rowPotential(numRows + 1, 0.0), columnPotential(numColumns + 1, 0.0);
+	std::vector<size_t> rowOfColumn(numColumns + 1, 0), previousColumn(numColumns + 1, 0);
+	std::vector<double> minSlack(numColumns + 1);
+	std::vector<char> visited(numColumns + 1);
+
+	for (size_t row = 1; row <= numRows; ++row) {
+		rowOfColumn[0] = row;
+		size_t column = 0;
+		std::fill(minSlack.begin(), minSlack.end(), kInfinity);
+		std::fill(visited.begin(), visited.end(), 0);
+
+		do {
+			visited[column] = 1;
+			size_t currentRow = rowOfColumn[column];
+			double delta = kInfinity;
+			size_t nextColumn = 0;
+			for (size_t c = 1; c <= numColumns; ++c) {
+				if (visited[c]) continue;
+				double slack = cost[currentRow - 1][c - 1] - rowPotential[currentRow] - columnPotential[c];
+				if (slack < minSlack[c]) {
+					minSlack[c] = slack;
+					previousColumn[c] = column;
+				}
+				if (minSlack[c] < delta) {
+					delta = minSlack[c];
+					nextColumn = c;
+				}
+			}
+			for (size_t c = 0; c <= numColumns; ++c) {
+				if (visited[c]) {
+					rowPotential[rowOfColumn[c]] += delta;
+					columnPotential[c] -= delta;
+				}
+				else {
+					minSlack[c] -= delta;
+				}
+			}
+			column = nextColumn;
+		} while (rowOfColumn[column] != 0);
+
+		// Flip the augmenting path
+		do {
+			size_t previous = previousColumn[column];
+			rowOfColumn[column] = rowOfColumn[previous];
+			column = previous;
+		} while (column != 0);
+	}
+
+	std::vector<int> columnOfRow(numRows, -1);
+	for (size_t c = 1; c <= numColumns; ++c) {
+		if (rowOfColumn[c] > 0) {
+			columnOfRow[rowOfColumn[c] - 1] = static_cast<int>(c - 1);
+		}
+	}
+	return columnOfRow;
+}
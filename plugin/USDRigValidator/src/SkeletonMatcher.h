@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Pairs the skeletons of a USD file with the joint hierarchies of a Maya scene for
+// whole-scene validation. Each side is reduced to a cheap signature. Pairs that share
+// a signature bucket with nothing else are taken as is, everything left over is
+// assigned by minimum total signature distance (Hungarian method). Pairs too far
+// apart to be the same character are not made, both sides stay unmatched.
+class SkeletonMatcher
+{
+public:
+	struct Signature {
+		unsigned int jointCount = 0;
+		std::vector<unsigned int> depthHistogram; // Joints per depth below the root
+		std::vector<int> sortedJointIds;          // JointPathTable ids, sorted
+		uint64_t nameHash = 0;                    // Over sortedJointIds, independent of joint order
+		std::string label;                        // Character name when one can be told, breaks ties between copies
+
+		// Bucket key, equal for skeletons with the same joint count, depths and names
+		uint64_t key() const;
+	};
+
+	static Signature signature(const ValidateRigCmd::USDSkeletonData& skeleton);
+	static Signature signature(const ValidateRigCmd::MayaSkeletonData& skeleton, const MDagPath& root);
+
+	// 0 for identical signatures, grows with every joint that differs
+	static double distance(const Signature& a, const Signature& b);
+
+	// True when a and b are close enough to be paired at all
+	static bool pairable(const Signature& a, const Signature& b);
+
+	// (USD index, Maya index) pairs sorted by USD index, each side used at most once
+	static std::vector<std::pair<int, int>> match(const std::vector<Signature>& usd,
+		const std::vector<Signature>& maya);
+
+private:
+	static Signature signature(const std::vector<int>& jointIds, const std::vector<int>& parentIndices,
+		const std::string& label);
+
+	// Column of each row minimizing the total cost, needs rows <= columns
+	static std::vector<int> assign(const std::vector<std::vector<double>>& cost);
+};
@@ -0,0 +1,82 @@
+#include "SkinClusterIndex.h"
+
+#include <maya/MStatus.h>
+#include <maya/MFnSkinCluster.h>
+#include <maya/MItDependencyNodes.h>
+
+void SkinClusterIndex::build()
+{
+	MStatus status;
+	m_entries.clear();
+	m_entryByMesh.clear();
+	m_bindPreMatrixByJoint.clear();
+
+	MItDependencyNodes itDep(MFn::kSkinClusterFilter);
+	for (; !itDep.isDone(); itDep.next()) {
+		MFnSkinCluster skinCluster(itDep.thisNode(), &status);
+		if (status != MS::kSuccess) continue;
+
+		Entry entry;
+		entry.node = itDep.thisNode();
+
+		MDagPathArray influencePaths;
+		unsigned int numInfluences = skinCluster.influenceObjects(influencePaths, &status);
+		for (unsigned int i = 0; i < numInfluences; ++i) {
+			entry.influencePaths.append(influencePaths[i].fullPathName());
+
+			unsigned int logicalIndex = skinCluster.indexForInfluenceObject(influencePaths[i], &status);
+			if (status == MS::kSuccess) {
+				m_bindPreMatrixByJoint.emplace(influencePaths[i].fullPathName().asChar(),
+					std::make_pair(m_entries.size(), logicalIndex));
+			}
+		}
+
+		unsigned int numGeoms = skinCluster.numOutputConnections();
+		for (unsigned int i = 0; i < numGeoms; i++) {
+			unsigned int index = skinCluster.indexForOutputConnection(i, &status);
+			MDagPath outputPath;
+			if (skinCluster.getPathAtIndex(index, outputPath) == MS::kSuccess) {
+				entry.outputPaths.append(outputPath);
+				m_entryByMesh.emplace(outputPath.fullPathName().asChar(), m_entries.size());
+			}
+		}
+
+		m_entries.push_back(entry);
+	}
+}
+
+MDagPathArray SkinClusterIndex::skinnedMeshes(const MDagPath& root) const
+{
+	MDagPathArray meshPaths;
+	MString rootPathStr = root.fullPathName();
+
+	for (const Entry& entry : m_entries) {
+		bool drivenByRoot = false;
+		for (unsigned int i = 0; i < entry.influencePaths.length() && !drivenByRoot; ++i) {
+			drivenByRoot = entry.influencePaths[i].indexW(rootPathStr) == 0;
+		}
+		if (!drivenByRoot) continue;
+
+		for (unsigned int i = 0; i < entry.outputPaths.length(); ++i) {
+			meshPaths.append(entry.outputPaths[i]);
+		}
+	}
+
+	return meshPaths;
+}
+
+MObject SkinClusterIndex::skinClusterFor(const MDagPath& meshPath) const
+{
+	auto it = m_entryByMesh.find(meshPath.fullPathName().asChar());
+	if (it == m_entryByMesh.end()) return MObject();
+	return m_entries[it->second].node;
+}
+
+bool SkinClusterIndex::bindPreMatrixFor(const MDagPath& jointPath, MObject& skinCluster, unsigned int& logicalIndex) const
+{
+	auto it = m_bindPreMatrixByJoint.find(jointPath.fullPathName().asChar());
+	if (it == m_bindPreMatrixByJoint.end()) return false;
+	skinCluster = m_entries[it->second.first].node;
+	logicalIndex = it->second.second;
+	return true;
+}
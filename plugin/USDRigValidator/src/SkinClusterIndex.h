@@ -0,0 +1,39 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <maya/MObject.h>
+#include <maya/MDagPath.h>
+#include <maya/MDagPathArray.h>
+#include <maya/MStringArray.h>
+
+// Every skin cluster in the scene with its influences and output meshes, gathered in
+// one pass over the dependency graph. Looking rigs up here instead of walking all skin
+// clusters once per root and once per mesh is what keeps batch runs from going quadratic.
+class SkinClusterIndex
+{
+public:
+	void build();
+
+	// Meshes deformed by a skin cluster with at least one influence under root
+	MDagPathArray skinnedMeshes(const MDagPath& root) const;
+
+	// Null when no skin cluster deforms the mesh
+	MObject skinClusterFor(const MDagPath& meshPath) const;
+
+	// The skin cluster and bindPreMatrix index of joint, from the first skin cluster it
+	// influences. False when it influences none.
+	bool bindPreMatrixFor(const MDagPath& jointPath, MObject& skinCluster, unsigned int& logicalIndex) const;
+
+private:
+	struct Entry {
+		MObject node;
+		MStringArray influencePaths; // Full DAG paths
+		MDagPathArray outputPaths;
+	};
+
+	std::vector<Entry> m_entries;
+	std::map<std::string, size_t> m_entryByMesh; // Full DAG path of an output mesh to its entry
+	std::map<std::string, std::pair<size_t, unsigned int>> m_bindPreMatrixByJoint; // Full DAG path to entry and index
+};
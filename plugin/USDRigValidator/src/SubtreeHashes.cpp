@@ -0,0 +1,51 @@
+#include "SubtreeHashes.h"
+
+#include <algorithm>
+
+namespace {
+
+uint64_t mix(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+}
+
+void SubtreeHashes::build(const std::vector<uint64_t>& leafHashes, const std::vector<int>& parentIndices,
+	uint64_t policyKey)
+{
+	int numJoints = static_cast<int>(leafHashes.size());
+	m_hashes = leafHashes;
+	m_subtreeEnd.resize(numJoints);
+	for (int i = 0; i < numJoints; ++i) {
+		m_subtreeEnd[i] = i + 1;
+	}
+
+	// Every descendant of a joint comes after it, so walking backwards finishes a joint's
+	// hash before it is folded into its parent. Siblings fold in last to first, which is
+	// the same on both sides for the same joint order.
+	for (int i = numJoints - 1; i > 0; --i) {
+		int parent = parentIndices[i];
+		if (parent < 0) continue;
+		if (parent >= i) {
+			// Out of order joints would leave children out of their parent's hash
+			clear();
+			return;
+		}
+		m_hashes[parent] = (m_hashes[parent] ^ mix(m_hashes[i])) * 0x9e3779b97f4a7c15ull;
+		m_subtreeEnd[parent] = std::max(m_subtreeEnd[parent], m_subtreeEnd[i]);
+	}
+	m_policyKey = policyKey;
+}
+
+void SubtreeHashes::clear()
+{
+	m_hashes.clear();
+	m_subtreeEnd.clear();
+	m_policyKey = 0;
+}
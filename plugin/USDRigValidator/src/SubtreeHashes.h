@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Merkle hashes over a skeleton's parent indices. A joint's leaf hash covers everything the
+// detailed check compares for it, and its subtree hash folds in the subtree hashes of its
+// children in joint order. Two skeletons whose hashes agree at a joint agree on every joint
+// below it, so a comparison can skip the subtree and only descends where they differ.
+//
+// Transforms enter the leaves through TolerancePolicy::provenHash, so the hashes are only
+// valid under the policy they were built with and tell which one that was.
+class SubtreeHashes
+{
+public:
+	// One leaf hash and parent index per joint, parents before their children
+	void build(const std::vector<uint64_t>& leafHashes, const std::vector<int>& parentIndices, uint64_t policyKey);
+	void clear();
+
+	bool builtFor(uint64_t policyKey) const { return !m_hashes.empty() && m_policyKey == policyKey; }
+	size_t size() const { return m_hashes.size(); }
+	uint64_t operator[](size_t joint) const { return m_hashes[joint]; }
+
+	// One past the last descendant of joint. The subtree is the range [joint, end) when the
+	// joints are in depth first order, as Maya's are.
+	int subtreeEnd(size_t joint) const { return m_subtreeEnd[joint]; }
+
+private:
+	std::vector<uint64_t> m_hashes;
+	std::vector<int> m_subtreeEnd;
+	uint64_t m_policyKey = 0;
+};
@@ -0,0 +1,213 @@
+#include "TolerancePolicy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+thread_local const TolerancePolicy* t_policy = nullptr;
+
+// Doubles mapped onto integers that order like the values, adjacent doubles are one apart
+int64_t orderedBits(double value)
+{
+	int64_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits < 0 ? std::numeric_limits<int64_t>::min() - bits : bits;
+}
+
+uint64_t ulpDistance(double a, double b)
+{
+	int64_t ia = orderedBits(a), ib = orderedBits(b);
+	return ia > ib ? static_cast<uint64_t>(ia) - static_cast<uint64_t>(ib) :
+		static_cast<uint64_t>(ib) - static_cast<uint64_t>(ia);
+}
+
+uint64_t mix(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdull;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ull;
+	value ^= value >> 33;
+	return value;
+}
+
+// Cells are this many times wider than the widest bound, so that only values within a
+// bound of a border can land apart from their match
+const double kCellsPerBound = 4.0;
+
+}
+
+TolerancePolicy::TolerancePolicy()
+{
+	linear.absolute = 1e-6;
+
+	// A float holds about 7 significant digits, translations are allowed to lose the 8th
+	translation.absolute = 1e-6;
+	translation.relative = 1e-7;
+
+	// Of the same size as the element bound at unit scale
+	scale.absolute = 1e-6;
+	scale.relative = 1e-7;
+	rotation = 1e-6;
+}
+
+bool TolerancePolicy::elementsMatch(double expected, double actual, const Bounds& bounds)
+{
+	double diff = std::abs(expected - actual);
+	if (diff <= bounds.absolute) return true;
+	if (diff <= bounds.relative * std::max(std::abs(expected), std::abs(actual))) return true;
+	return bounds.ulps > 0 && ulpDistance(expected, actual) <= bounds.ulps;
+}
+
+bool TolerancePolicy::matches(const double* expected, const double* actual) const
+{
+	for (int k = 0; k < 16; ++k) {
+		if (!elementsMatch(expected[k], actual[k], bounds(k))) return false;
+	}
+	return true;
+}
+
+bool TolerancePolicy::matches(const GfMatrix4d& usdMat, const MMatrix& mayaMat) const
+{
+	for (int row = 0; row < 4; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			if (!elementsMatch(usdMat[row][col], mayaMat(row, col), bounds(row * 4 + col))) return false;
+		}
+	}
+	return true;
+}
+
+double TolerancePolicy::allowance(int element, double expected) const
+{
+	// The relative and ULP bounds grow with the larger magnitude, expected's is a lower bound
+	const Bounds& b = bounds(element);
+	double magnitude = std::abs(expected);
+	double allowed = std::max(b.absolute, b.relative * magnitude);
+	if (b.ulps > 0 && magnitude > 0.0 && std::isfinite(magnitude)) {
+		double ulp = std::nextafter(magnitude, 0.0);
+		allowed = std::max(allowed, (magnitude - ulp) * static_cast<double>(b.ulps));
+	}
+	return allowed;
+}
+
+uint64_t TolerancePolicy::quantizedHash(const double* m) const
+{
+	uint64_t hash = 0x9e3779b97f4a7c15ull;
+	for (int k = 0; k < 16; ++k) {
+		double value = m[k];
+		int exponent = 0;
+		std::frexp(value, &exponent);
+
+		// Bounds scale with magnitude, so the cell width is fixed per binade: the widest
+		// bound anywhere in it, rounded up to a power of two
+		const Bounds& b = bounds(k);
+		double binadeTop = std::ldexp(1.0, exponent);
+		double widest = std::max(b.absolute, b.relative * binadeTop);
+		if (b.ulps > 0) {
+			widest = std::max(widest, std::ldexp(static_cast<double>(b.ulps), exponent - 52));
+		}
+		int cellExponent = 0;
+		std::frexp(std::max(widest * kCellsPerBound, std::numeric_limits<double>::min()), &cellExponent);
+
+		// Values within a few absolute bounds of zero share one cell whatever their binade
+		uint64_t cell = 0;
+		if (std::abs(value) > b.absolute * kCellsPerBound && std::isfinite(value)) {
+			int64_t index = static_cast<int64_t>(std::floor(std::ldexp(value, -cellExponent)));
+			cell = mix(static_cast<uint64_t>(index)) ^ static_cast<uint64_t>(cellExponent);
+		}
+		hash = (hash ^ mix(cell + static_cast<uint64_t>(k))) * 0x9e3779b97f4a7c15ull;
+	}
+	return mix(hash);
+}
+
+uint64_t TolerancePolicy::quantizedHash(const GfMatrix4d& m) const
+{
+	return quantizedHash(m.GetArray());
+}
+
+uint64_t TolerancePolicy::quantizedHash(const MMatrix& m) const
+{
+	return quantizedHash(&m.matrix[0][0]);
+}
+
+uint64_t TolerancePolicy::provenHash(const double* m) const
+{
+	uint64_t hash = 0x9e3779b97f4a7c15ull;
+	for (int k = 0; k < 16; ++k) {
+		double value = m[k];
+		const Bounds& b = bounds(k);
+
+		// Values within half the absolute bound of zero are within it of each other
+		uint64_t cell = 0;
+		if (std::abs(value) > b.absolute * 0.5) {
+			// The bound any two values of the binade are allowed, taken at its bottom, and a
+			// power of two cell width no larger than that. Both values of a pair must share
+			// the binade for the width to apply, so it is part of the cell.
+			int exponent = 0;
+			std::frexp(value, &exponent);
+			double guaranteed = std::max(b.absolute, b.relative * std::ldexp(1.0, exponent - 1));
+			if (b.ulps > 0) {
+				guaranteed = std::max(guaranteed, std::ldexp(static_cast<double>(b.ulps), exponent - 53));
+			}
+
+			int cellExponent = 0;
+			std::frexp(guaranteed, &cellExponent);
+			double scaled = std::ldexp(value, 1 - cellExponent);
+			if (guaranteed > 0.0 && std::abs(scaled) < 1e18) {
+				int64_t index = static_cast<int64_t>(std::floor(scaled));
+				cell = mix(static_cast<uint64_t>(index)) ^ (static_cast<uint64_t>(static_cast<uint32_t>(exponent)) << 32);
+			}
+			else {
+				// No bound, or cells too fine to count: only identical values share a key
+				std::memcpy(&cell, &value, sizeof(cell));
+				cell = mix(cell);
+			}
+		}
+		hash = (hash ^ mix(cell + static_cast<uint64_t>(k))) * 0x9e3779b97f4a7c15ull;
+	}
+	return mix(hash);
+}
+
+uint64_t TolerancePolicy::key() const
+{
+	std::vector<double> settings;
+	appendSettings(settings);
+
+	uint64_t hash = 0x9e3779b97f4a7c15ull;
+	for (double setting : settings) {
+		uint64_t bits;
+		std::memcpy(&bits, &setting, sizeof(bits));
+		hash = (hash ^ mix(bits)) * 0x9e3779b97f4a7c15ull;
+	}
+	return mix(hash);
+}
+
+void TolerancePolicy::appendSettings(std::vector<double>& settings) const
+{
+	for (const Bounds* b : { &linear, &translation, &scale }) {
+		settings.push_back(b->absolute);
+		settings.push_back(b->relative);
+		settings.push_back(static_cast<double>(b->ulps));
+	}
+	settings.push_back(rotation);
+}
+
+const TolerancePolicy& TolerancePolicy::current()
+{
+	static const TolerancePolicy s_defaults;
+	return t_policy ? *t_policy : s_defaults;
+}
+
+TolerancePolicy::Scope::Scope(const TolerancePolicy& policy) :
+	m_previous(t_policy)
+{
+	t_policy = &policy;
+}
+
+TolerancePolicy::Scope::~Scope()
+{
+	t_policy = m_previous;
+}
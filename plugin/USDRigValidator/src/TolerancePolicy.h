@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <maya/MMatrix.h>
+#include <pxr/pxr.h>
+#include <pxr/base/gf/matrix4d.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+// How far a Maya matrix element may be from its USD counterpart and still match. The
+// elements fall in two groups with bounds of their own: the upper 3x3 with the
+// projective column, and the translation row. An element matches when any bound of
+// its group holds: the absolute difference, the difference relative to the larger of
+// the two magnitudes, or the distance in units in the last place.
+//
+// A fixed absolute bound fails large world space translations, whose float round trip
+// through USD loses more than 1e-6, hence the relative bound on translations.
+//
+// Matrices that fail element wise are decomposed by TransformDecomposition, and still
+// match when translation, rotation and scale are each within their own bound.
+class TolerancePolicy
+{
+public:
+	struct Bounds {
+		double absolute = 0.0;
+		double relative = 0.0;
+		uint64_t ulps = 0;
+	};
+
+	Bounds linear;      // Rotation, scale and shear, plus the projective column
+	Bounds translation; // Row 3, columns 0 to 2
+	Bounds scale;       // Decomposed scale, per axis
+	double rotation;    // Decomposed rotation angle in radians, also the shear allowed
+
+	TolerancePolicy();
+
+	// Elements are numbered row major, 0 to 15
+	static bool isTranslation(int element) { return element >= 12 && element < 15; }
+	const Bounds& bounds(int element) const { return isTranslation(element) ? translation : linear; }
+
+	static bool elementsMatch(double expected, double actual, const Bounds& bounds);
+
+	// Row major, 16 elements each
+	bool matches(const double* expected, const double* actual) const;
+	bool matches(const GfMatrix4d& usdMat, const MMatrix& mayaMat) const;
+
+	// A difference at an element that always matches when expected is the USD value, for
+	// screens on approximate copies that must not clear a real mismatch
+	double allowance(int element, double expected) const;
+
+	// Hash over each element quantized to cells several times wider than its bounds.
+	// Matching matrices share a key unless an element sits close to a cell border, so
+	// bucketing by key finds match candidates in O(1). Candidates still go through
+	// matches(), and a lookup that finds none has to fall back to a full search.
+	uint64_t quantizedHash(const double* m) const;
+	uint64_t quantizedHash(const GfMatrix4d& m) const;
+	uint64_t quantizedHash(const MMatrix& m) const;
+
+	// Hash over cells no wider than the bounds, so matrices with equal keys are certain to
+	// match. Matching matrices still get different keys when an element sits on either side
+	// of a cell border, the key can only prove a match, never rule one out.
+	uint64_t provenHash(const double* m) const;
+
+	// Hash of appendSettings, tells which policy derived data was built under
+	uint64_t key() const;
+
+	// Every number the policy is made of, for ResultCache keys
+	void appendSettings(std::vector<double>& settings) const;
+
+	// The policy installed on this thread, or the defaults
+	static const TolerancePolicy& current();
+
+	// Makes policy current on this thread for the lifetime of the scope, the policy must
+	// outlive it. Workers comparing on behalf of a scoped caller install it again.
+	class Scope {
+	public:
+		explicit Scope(const TolerancePolicy& policy);
+		~Scope();
+
+	private:
+		const TolerancePolicy* m_previous;
+	};
+};
@@ -0,0 +1,167 @@
+#include "TransformDecomposition.h"
+#include "TolerancePolicy.h"
+#include "RunArena.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+TransformDecomposition::TransformDecomposition() :
+	m_count(0), m_components(RunArena::current()), m_decomposed(RunArena::current())
+{
+}
+
+void TransformDecomposition::decompose(const double* matrices, size_t count, const TolerancePolicy& policy)
+{
+	m_count = count;
+	m_components.assign(count * kNumComponents, 0.0);
+	m_decomposed.assign(count, 0);
+
+	double* translate[3] = { column(kTranslate), column(kTranslate + 1), column(kTranslate + 2) };
+	double* rotate[4] = { column(kRotate), column(kRotate + 1), column(kRotate + 2), column(kRotate + 3) };
+	double* scale[3] = { column(kScale), column(kScale + 1), column(kScale + 2) };
+
+	// Translation, scale and the shear test, straight line code per matrix
+	const double maxCosine = policy.rotation;
+	for (size_t i = 0; i < count; ++i) {
+		const double* a = matrices + i * 16;
+		translate[0][i] = a[12];
+		translate[1][i] = a[13];
+		translate[2][i] = a[14];
+
+		double lx = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+		double ly = std::sqrt(a[4] * a[4] + a[5] * a[5] + a[6] * a[6]);
+		double lz = std::sqrt(a[8] * a[8] + a[9] * a[9] + a[10] * a[10]);
+		double det = a[0] * (a[5] * a[10] - a[6] * a[9]) - a[1] * (a[4] * a[10] - a[6] * a[8]) +
+			a[2] * (a[4] * a[9] - a[5] * a[8]);
+		scale[0][i] = det < 0.0 ? -lx : lx;
+		scale[1][i] = ly;
+		scale[2][i] = lz;
+
+		// Cosines between the axes, NaN for a degenerate axis, which then fails the test
+		double cxy = (a[0] * a[4] + a[1] * a[5] + a[2] * a[6]) / (lx * ly);
+		double cxz = (a[0] * a[8] + a[1] * a[9] + a[2] * a[10]) / (lx * lz);
+		double cyz = (a[4] * a[8] + a[5] * a[9] + a[6] * a[10]) / (ly * lz);
+		bool orthogonal = std::abs(cxy) <= maxCosine && std::abs(cxz) <= maxCosine && std::abs(cyz) <= maxCosine;
+		bool affine = TolerancePolicy::elementsMatch(0.0, a[3], policy.linear) &&
+			TolerancePolicy::elementsMatch(0.0, a[7], policy.linear) &&
+			TolerancePolicy::elementsMatch(0.0, a[11], policy.linear) &&
+			TolerancePolicy::elementsMatch(1.0, a[15], policy.linear);
+		m_decomposed[i] = orthogonal && affine;
+	}
+
+	// Rotation, Shepperd's method picks the largest of w, x, y, z to divide by
+	for (size_t i = 0; i < count; ++i) {
+		const double* a = matrices + i * 16;
+		double sx = scale[0][i], sy = scale[1][i], sz = scale[2][i];
+		double r00 = a[0] / sx, r01 = a[1] / sx, r02 = a[2] / sx;
+		double r10 = a[4] / sy, r11 = a[5] / sy, r12 = a[6] / sy;
+		double r20 = a[8] / sz, r21 = a[9] / sz, r22 = a[10] / sz;
+
+		double w, x, y, z;
+		double trace = r00 + r11 + r22;
+		if (trace > 0.0) {
+			double s = std::sqrt(trace + 1.0) * 2.0;
+			w = 0.25 * s;
+			x = (r12 - r21) / s;
+			y = (r20 - r02) / s;
+			z = (r01 - r10) / s;
+		}
+		else if (r00 > r11 && r00 > r22) {
+			double s = std::sqrt(1.0 + r00 - r11 - r22) * 2.0;
+			w = (r12 - r21) / s;
+			x = 0.25 * s;
+			y = (r10 + r01) / s;
+			z = (r20 + r02) / s;
+		}
+		else if (r11 > r22) {
+			double s = std::sqrt(1.0 + r11 - r00 - r22) * 2.0;
+			w = (r20 - r02) / s;
+			x = (r10 + r01) / s;
+			y = 0.25 * s;
+			z = (r21 + r12) / s;
+		}
+		else {
+			double s = std::sqrt(1.0 + r22 - r00 - r11) * 2.0;
+			w = (r01 - r10) / s;
+			x = (r20 + r02) / s;
+			y = (r21 + r12) / s;
+			z = 0.25 * s;
+		}
+
+		double norm = std::sqrt(w * w + x * x + y * y + z * z);
+		double sign = w < 0.0 ? -1.0 : 1.0;
+		rotate[0][i] = sign * w / norm;
+		rotate[1][i] = sign * x / norm;
+		rotate[2][i] = sign * y / norm;
+		rotate[3][i] = sign * z / norm;
+	}
+}
+
+void TransformDecomposition::compare(const double* usd, const double* maya, size_t count,
+	const TolerancePolicy& policy, Errors* errors)
+{
+	TransformDecomposition usdParts, mayaParts;
+	usdParts.decompose(usd, count, policy);
+	mayaParts.decompose(maya, count, policy);
+
+	for (size_t i = 0; i < count; ++i) {
+		Errors& e = errors[i];
+		e = Errors();
+		const double* a = usd + i * 16;
+		const double* b = maya + i * 16;
+		for (int k = 0; k < 16; ++k) {
+			e.element = std::max(e.element, std::abs(a[k] - b[k]));
+		}
+
+		bool componentsMatch = true;
+		for (int c = 0; c < 3; ++c) {
+			double expected = usdParts.column(kTranslate + c)[i];
+			double actual = mayaParts.column(kTranslate + c)[i];
+			e.translation = std::max(e.translation, std::abs(expected - actual));
+			componentsMatch = componentsMatch && TolerancePolicy::elementsMatch(expected, actual, policy.translation);
+		}
+
+		e.decomposed = usdParts.m_decomposed[i] && mayaParts.m_decomposed[i];
+		if (e.decomposed) {
+			for (int c = 0; c < 3; ++c) {
+				double expected = usdParts.column(kScale + c)[i];
+				double actual = mayaParts.column(kScale + c)[i];
+				e.scale = std::max(e.scale, std::abs(expected - actual));
+				componentsMatch = componentsMatch && TolerancePolicy::elementsMatch(expected, actual, policy.scale);
+			}
+
+			// q and -q are the same rotation, half turns can come out with either sign. The
+			// angle between the quaternions is half the rotation angle, atan2 keeps small
+			// angles exact where acos of the dot product would lose them.
+			double dot = 0.0;
+			for (int c = 0; c < 4; ++c) {
+				dot += usdParts.column(kRotate + c)[i] * mayaParts.column(kRotate + c)[i];
+			}
+			double sign = dot < 0.0 ? -1.0 : 1.0;
+			double sumSq = 0.0, diffSq = 0.0;
+			for (int c = 0; c < 4; ++c) {
+				double u = usdParts.column(kRotate + c)[i];
+				double m = sign * mayaParts.column(kRotate + c)[i];
+				sumSq += (u + m) * (u + m);
+				diffSq += (u - m) * (u - m);
+			}
+			e.rotation = 4.0 * std::atan2(std::sqrt(diffSq), std::sqrt(sumSq));
+			componentsMatch = componentsMatch && e.rotation <= policy.rotation;
+		}
+
+		e.matches = policy.matches(a, b) || (e.decomposed && componentsMatch);
+	}
+}
+
+TransformDecomposition::Errors TransformDecomposition::compare(const GfMatrix4d& usdMat, const MMatrix& mayaMat,
+	const TolerancePolicy& policy)
+{
+	double usd[16], maya[16];
+	std::memcpy(usd, usdMat.GetArray(), sizeof(usd));
+	std::memcpy(maya, &mayaMat.matrix[0][0], sizeof(maya));
+
+	Errors errors;
+	compare(usd, maya, 1, policy, &errors);
+	return errors;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+#include <maya/MMatrix.h>
+#include <pxr/pxr.h>
+#include <pxr/base/gf/matrix4d.h>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+class TolerancePolicy;
+
+// Translation, rotation and scale of a batch of row major 4x4 matrices, one array per
+// component so each step of the decomposition runs front to back over plain doubles.
+// Rotations are unit quaternions with w >= 0, a negative determinant is folded into the
+// x scale. A matrix with shear or a projective column beyond the policy's bounds is
+// marked as not decomposed.
+class TransformDecomposition
+{
+public:
+	// How far two transforms are apart, component by component
+	struct Errors {
+		double translation = 0.0; // Largest difference of the translate values
+		double rotation = 0.0;    // Angle of the rotation between the two, radians
+		double scale = 0.0;       // Largest difference of the scale values
+		double element = 0.0;     // Largest difference of the 16 matrix elements
+		bool decomposed = true;   // Both sides free of shear and perspective
+		bool matches = true;
+	};
+
+	// Scratch comes from RunArena::current()
+	TransformDecomposition();
+
+	// matrices holds count matrices of 16 contiguous doubles
+	void decompose(const double* matrices, size_t count, const TolerancePolicy& policy);
+
+	// A pair matches when its elements do, or when both decompose and each component is
+	// within its own bound. errors receives count entries.
+	static void compare(const double* usd, const double* maya, size_t count,
+		const TolerancePolicy& policy, Errors* errors);
+	static Errors compare(const GfMatrix4d& usdMat, const MMatrix& mayaMat, const TolerancePolicy& policy);
+
+private:
+	// Component c of matrix i is at m_components[c * m_count + i]
+	enum { kTranslate = 0, kRotate = 3, kScale = 7, kNumComponents = 10 }; // Rotation is w, x, y, z
+
+	size_t m_count;
+	std::pmr::vector<double> m_components;
+	std::pmr::vector<unsigned char> m_decomposed;
+
+	double* column(int component) { return m_components.data() + component * m_count; }
+	const double* column(int component) const { return m_components.data() + component * m_count; }
+};
@@ -1,7 +1,28 @@
 #include "ValidateRigCmd.h"
+#include "ValidationSession.h"
+#include "ValidationJob.h"
+#include "ValidationLog.h"
+#include "ValidationReport.h"
+#include "ResultCache.h"
+#include "ValidationBatch.h"
+#include "SkinClusterIndex.h"
+#include "RunArena.h"
+#include "JointPathTable.h"
+#include "TolerancePolicy.h"
+#include "InfluenceIndex.h"
+#include "SceneCache.h"
+#include "SkelPrimIndex.h"
 
 #include <memory>
+#include <future>
 #include <cstdlib>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <map>
+#include <unordered_map>
 #include <maya/MGlobal.h>
 #include <maya/MString.h>
 #include <maya/MFnDagNode.h>
@@ -21,16 +42,27 @@
 #include <maya/MDagPathArray.h>
 #include <maya/MMatrix.h>
 #include <maya/MFnIkJoint.h>
+#include <maya/MSelectionList.h>
+#include <maya/MTime.h>
+#include <maya/MDGContext.h>
+#include <maya/MDGContextGuard.h>
 #include <pxr/usd/usd/stage.h>
 #include <pxr/usd/usd/prim.h>
 #include <pxr/usd/usd/primRange.h>
 #include <pxr/usd/usd/attribute.h>
 #include <pxr/usd/usdSkel/skeleton.h>
+#include <pxr/usd/usdGeom/tokens.h>
 #include <pxr/usd/usdSkel/topology.h>
+#include <pxr/usd/usdSkel/bindingAPI.h>
+#include <pxr/usd/usdGeom/primvar.h>
+#include <pxr/usd/usdSkel/root.h>
+#include <pxr/usd/usdSkel/cache.h>
+#include <pxr/usd/usdSkel/skeletonQuery.h>
 #include <pxr/base/vt/array.h>
 #include <pxr/base/gf/matrix4d.h>
 #include <pxr/base/tf/token.h>
 #include <pxr/usd/sdf/path.h>
+#include <pxr/base/work/loops.h>
 
 const char* ValidateRigCmd::commandName = "validateRig";
 
@@ -38,9 +70,437 @@ const char* ValidateRigCmd::rootFlag = "-r";
 const char* ValidateRigCmd::rootFlagLong = "-root";
 const char* ValidateRigCmd::pathFlag = "-u";
 const char* ValidateRigCmd::pathFlagLong = "-usdFile";
+const char* ValidateRigCmd::incrementalFlag = "-i";
+const char* ValidateRigCmd::incrementalFlagLong = "-incremental";
+const char* ValidateRigCmd::clearSessionFlag = "-cs";
+const char* ValidateRigCmd::clearSessionFlagLong = "-clearSession";
+const char* ValidateRigCmd::asyncFlag = "-a";
+const char* ValidateRigCmd::asyncFlagLong = "-async";
+const char* ValidateRigCmd::jobStatusFlag = "-js";
+const char* ValidateRigCmd::jobStatusFlagLong = "-jobStatus";
+const char* ValidateRigCmd::progressFlag = "-p";
+const char* ValidateRigCmd::progressFlagLong = "-progress";
+const char* ValidateRigCmd::cancelFlag = "-c";
+const char* ValidateRigCmd::cancelFlagLong = "-cancel";
+const char* ValidateRigCmd::resultFlag = "-res";
+const char* ValidateRigCmd::resultFlagLong = "-result";
+const char* ValidateRigCmd::frameRangeFlag = "-fr";
+const char* ValidateRigCmd::frameRangeFlagLong = "-frameRange";
+const char* ValidateRigCmd::frameStepFlag = "-fs";
+const char* ValidateRigCmd::frameStepFlagLong = "-frameStep";
+const char* ValidateRigCmd::reportFlag = "-rp";
+const char* ValidateRigCmd::reportFlagLong = "-report";
+const char* ValidateRigCmd::maxSamplesFlag = "-ms";
+const char* ValidateRigCmd::maxSamplesFlagLong = "-maxSamples";
+const char* ValidateRigCmd::manifestFlag = "-m";
+const char* ValidateRigCmd::manifestFlagLong = "-manifest";
+const char* ValidateRigCmd::resultCacheFlag = "-rc";
+const char* ValidateRigCmd::resultCacheFlagLong = "-resultCache";
+const char* ValidateRigCmd::streamSkinsFlag = "-ss";
+const char* ValidateRigCmd::streamSkinsFlagLong = "-streamSkins";
+const char* ValidateRigCmd::compactFlag = "-cp";
+const char* ValidateRigCmd::compactFlagLong = "-compact";
+const char* ValidateRigCmd::matchSkeletonsFlag = "-msk";
+const char* ValidateRigCmd::matchSkeletonsFlagLong = "-matchSkeletons";
+const char* ValidateRigCmd::linearToleranceFlag = "-lt";
+const char* ValidateRigCmd::linearToleranceFlagLong = "-linearTolerance";
+const char* ValidateRigCmd::translationToleranceFlag = "-tt";
+const char* ValidateRigCmd::translationToleranceFlagLong = "-translationTolerance";
+const char* ValidateRigCmd::scaleToleranceFlag = "-st";
+const char* ValidateRigCmd::scaleToleranceFlagLong = "-scaleTolerance";
+const char* ValidateRigCmd::rotationToleranceFlag = "-rt";
+const char* ValidateRigCmd::rotationToleranceFlagLong = "-rotationTolerance";
+
+// Resident session reused by -incremental calls, see ValidationSession
+static std::unique_ptr<ValidationSession> s_session;
+
+// Running and finished -async jobs by handle, released once their result is fetched
+static std::map<int, std::unique_ptr<ValidationJob>> s_jobs;
+static int s_nextJobId = 1;
+
+namespace {
+
+// Weights at or below this are dropped on extraction, and ignored on the USD side to match
+const double kWeightPruneThreshold = 0.0001;
+const float kWeightTolerance = 1e-5f;
+// Animation is stored in float/half on the USD side, so the static 1e-6 tolerance is too tight
+const double kAnimationTolerance = 1e-4;
+const double kDegreesPerRadian = 180.0 / 3.14159265358979323846;
+
+struct InfluenceWeight {
+	int joint;
+	float weight;
+};
+
+// The sparse influences of a single vertex, sorted by joint and normalized to sum to one.
+// Rows up to kInlineInfluences wide stay in the fixed buffer, wider rows spill to the heap.
+class SkinRow {
+public:
+	static const int kInlineInfluences = 16;
+
+	void clear() {
+		m_count = 0;
+		m_overflow.clear();
+	}
+
+	void add(int joint, float weight) {
+		if (m_count < kInlineInfluences) {
+			m_inline[m_count] = { joint, weight };
+		}
+		else {
+			if (m_count == kInlineInfluences) {
+				m_overflow.assign(m_inline, m_inline + kInlineInfluences);
+			}
+			m_overflow.push_back({ joint, weight });
+		}
+		m_count++;
+	}
+
+	int size() const { return m_count; }
+	const InfluenceWeight& operator[](int i) const { return data()[i]; }
+
+	void normalize() {
+		InfluenceWeight* entries = data();
+		std::sort(entries, entries + m_count,
+			[](const InfluenceWeight& a, const InfluenceWeight& b) { return a.joint < b.joint; });
+
+		// Merge duplicate joints, USD allows the same joint to appear twice in a row
+		int unique = 0;
+		double sum = 0.0;
+		for (int i = 0; i < m_count; ++i) {
+			if (unique > 0 && entries[unique - 1].joint == entries[i].joint) {
+				entries[unique - 1].weight += entries[i].weight;
+			}
+			else {
+				entries[unique++] = entries[i];
+			}
+			sum += entries[i].weight;
+		}
+		m_count = unique;
+		if (m_count > kInlineInfluences) {
+			m_overflow.resize(m_count);
+		}
+		else if (!m_overflow.empty()) {
+			std::copy(m_overflow.begin(), m_overflow.begin() + m_count, m_inline);
+			m_overflow.clear();
+		}
+
+		if (sum > 0.0) {
+			entries = data();
+			for (int i = 0; i < m_count; ++i) {
+				entries[i].weight = static_cast<float>(entries[i].weight / sum);
+			}
+		}
+	}
+
+private:
+	InfluenceWeight* data() { return m_overflow.empty() ? m_inline : m_overflow.data(); }
+	const InfluenceWeight* data() const { return m_overflow.empty() ? m_inline : m_overflow.data(); }
+
+	InfluenceWeight m_inline[kInlineInfluences];
+	std::vector<InfluenceWeight> m_overflow;
+	int m_count = 0;
+};
+
+enum class SkinVertexResult : unsigned char {
+	MATCH,
+	INFLUENCE_MISMATCH,
+	WEIGHT_MISMATCH
+};
+
+void readUSDSkinRow(const ValidateRigCmd::USDSkinBindingData& usdSkin, size_t vertex, SkinRow& row)
+{
+	row.clear();
+	const size_t begin = usdSkin.constant ? 0 : vertex * usdSkin.elementSize;
+	for (size_t i = begin; i < begin + usdSkin.elementSize; ++i) {
+		if (usdSkin.jointWeights[i] > kWeightPruneThreshold) {
+			row.add(usdSkin.jointIndices[i], usdSkin.jointWeights[i]);
+		}
+	}
+	row.normalize();
+}
+
+void readMayaSkinRow(const ValidateRigCmd::MayaSkinBindingData& mayaSkin, unsigned int vertex, SkinRow& row)
+{
+	row.clear();
+	for (int i = mayaSkin.vertexOffsets[vertex]; i < mayaSkin.vertexOffsets[vertex + 1]; ++i) {
+		row.add(mayaSkin.jointIndices[i], mayaSkin.jointWeights[i]);
+	}
+	row.normalize();
+}
+
+// Compares two normalized rows independent of the order influences were authored in.
+// maxDiff receives the largest weight difference when the influence sets agree.
+SkinVertexResult compareSkinRows(const SkinRow& usdRow, const SkinRow& mayaRow, float& maxDiff)
+{
+	maxDiff = 0.0f;
+	if (usdRow.size() != mayaRow.size()) return SkinVertexResult::INFLUENCE_MISMATCH;
+
+	for (int i = 0; i < usdRow.size(); ++i) {
+		if (usdRow[i].joint != mayaRow[i].joint) return SkinVertexResult::INFLUENCE_MISMATCH;
+		maxDiff = std::max(maxDiff, std::abs(usdRow[i].weight - mayaRow[i].weight));
+	}
+
+	return maxDiff > kWeightTolerance ? SkinVertexResult::WEIGHT_MISMATCH : SkinVertexResult::MATCH;
+}
+
+// Tolerances at or above this leave room for float32 rounding at typical rig magnitudes,
+// tighter ones make the compact kernels take their differences in double
+const double kFloatKernelTolerance = 1e-4;
+
+// Whether a USD element and its float32 Maya copy may be more than tolerance apart. Adds a
+// bound on what float rounding may have hidden, so a cleared element is certain to match.
+inline bool compactElementMayDiffer(double usd, float maya, double tolerance)
+{
+	const double kFloatRounding = 1.0 / (1 << 23);
+	double diff, bound;
+	if (tolerance >= kFloatKernelTolerance) {
+		diff = std::abs(static_cast<float>(usd) - maya);
+		bound = (std::abs(usd) + std::abs(maya)) * kFloatRounding;
+	}
+	else {
+		diff = std::abs(usd - static_cast<double>(maya));
+		bound = std::abs(maya) * kFloatRounding;
+	}
+	return diff + bound > tolerance;
+}
+
+bool compactMatrixMayDiffer(const GfMatrix4d& usdMat, const ValidateRigCmd::CompactMatrixArray& mayaMats,
+	size_t i, const TolerancePolicy& policy)
+{
+	for (int row = 0; row < 4; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			double usd = usdMat[row][col];
+			if (compactElementMayDiffer(usd, mayaMats.get(i, row, col), policy.allowance(row * 4 + col, usd))) return true;
+		}
+	}
+	return false;
+}
+
+// Flags the joints compactMatrixMayDiffer would, one matrix element across all joints at
+// a time so each float array is read front to back
+void screenCompactTransforms(const VtArray<GfMatrix4d>& usdMats, const ValidateRigCmd::CompactMatrixArray& mayaMats,
+	const TolerancePolicy& policy, std::vector<unsigned char>& flagged)
+{
+	size_t count = std::min(usdMats.size(), mayaMats.size());
+	flagged.assign(count, 0);
+	for (int k = 0; k < 16; ++k) {
+		const float* maya = mayaMats.elements[k].data();
+		for (size_t i = 0; i < count; ++i) {
+			double usd = usdMats[i][k / 4][k % 4];
+			flagged[i] |= compactElementMayDiffer(usd, maya[i], policy.allowance(k, usd));
+		}
+	}
+}
+
+// Bind or rest transforms of the listed joints, which both sides must have, packed and
+// decomposed in one batch under the current policy. errors receives an entry per joint.
+void compareJointTransforms(const VtArray<GfMatrix4d>& usdMats, const MMatrixArray& mayaMats,
+	const std::pmr::vector<int>& joints, std::pmr::vector<TransformDecomposition::Errors>& errors)
+{
+	size_t count = joints.size();
+	std::pmr::vector<double> usd(count * 16, RunArena::current());
+	std::pmr::vector<double> maya(count * 16, RunArena::current());
+	for (size_t k = 0; k < count; ++k) {
+		std::memcpy(&usd[k * 16], usdMats[joints[k]].GetArray(), 16 * sizeof(double));
+		std::memcpy(&maya[k * 16], &mayaMats[static_cast<unsigned int>(joints[k])].matrix[0][0], 16 * sizeof(double));
+	}
+
+	errors.resize(count);
+	TransformDecomposition::compare(usd.data(), maya.data(), count, TolerancePolicy::current(), errors.data());
+}
+
+// Everything detailedValidateJoint compares for a joint, transforms by their proven cells
+uint64_t jointLeafHash(size_t joint, int jointId, int parent, const double* bind, const double* rest,
+	const TolerancePolicy& policy)
+{
+	ContentHash hash;
+	hash.addValue(static_cast<uint64_t>(joint));
+	hash.addValue(jointId);
+	hash.addValue(parent);
+	hash.addValue(policy.provenHash(bind));
+	hash.addValue(policy.provenHash(rest));
+	return hash.value();
+}
+
+// Per component errors of a transform mismatch, as packed by makeTransformMismatch
+MString describeTransformErrors(const ValidateRigCmd::ValidationIssue& issue)
+{
+	MString desc;
+	if (issue.actual < 0.0) {
+		desc.format("translate off by ^1s, max element diff=^2s, shear or perspective keeps it from decomposing",
+			MString() + issue.expected,
+			MString() + issue.diff);
+	}
+	else {
+		desc.format("translate off by ^1s, rotate by ^2s deg, scale by ^3s",
+			MString() + issue.expected,
+			MString() + issue.actual * kDegreesPerRadian,
+			MString() + issue.scaleDiff);
+	}
+	return desc;
+}
+
+// USD joint whose bind transform matches mayaMat under the current policy, or -1. Bucket
+// candidates are tried first, a matrix near a cell border needs the full search.
+int findBindTransform(const VtArray<GfMatrix4d>& usdMats, const std::unordered_multimap<uint64_t, int>& buckets,
+	const MMatrix& mayaMat)
+{
+	const TolerancePolicy& policy = TolerancePolicy::current();
+	auto range = buckets.equal_range(policy.quantizedHash(mayaMat));
+	for (auto it = range.first; it != range.second; ++it) {
+		if (policy.matches(usdMats[it->second], mayaMat)) return it->second;
+	}
+	for (size_t j = 0; j < usdMats.size(); ++j) {
+		if (policy.matches(usdMats[j], mayaMat)) return static_cast<int>(j);
+	}
+	return -1;
+}
+
+// Absolute, relative and ULP bounds of a tolerance flag
+MStatus readToleranceBounds(const MArgDatabase& argData, const char* flag, TolerancePolicy::Bounds& bounds)
+{
+	int ulps = 0;
+	argData.getFlagArgument(flag, 0, bounds.absolute);
+	argData.getFlagArgument(flag, 1, bounds.relative);
+	argData.getFlagArgument(flag, 2, ulps);
+	if (bounds.absolute < 0.0 || bounds.relative < 0.0 || ulps < 0) {
+		MGlobal::displayError(MString(flag) + " bounds cannot be negative");
+		return MS::kInvalidParameter;
+	}
+	bounds.ulps = static_cast<uint64_t>(ulps);
+	return MS::kSuccess;
+}
+
+// Vertices compared per work item in detailedValidateSkinBinding
+const size_t kSkinChunkSize = 4096;
+
+// Number of vertices both sides describe, or -1 if the bindings disagree on it
+long long skinVertexCount(const ValidateRigCmd::USDSkinBindingData& usdSkin,
+	const ValidateRigCmd::MayaSkinBindingData& mayaSkin)
+{
+	if (usdSkin.elementSize <= 0) return -1;
+	if (usdSkin.jointIndices.size() != usdSkin.jointWeights.size()) return -1;
+	if (mayaSkin.vertexOffsets.length() == 0) return -1;
+
+	size_t mayaVertexCount = mayaSkin.vertexOffsets.length() - 1;
+	if (usdSkin.constant) {
+		// One row broadcast to every vertex Maya has
+		if (usdSkin.jointIndices.size() != static_cast<size_t>(usdSkin.elementSize)) return -1;
+		return static_cast<long long>(mayaVertexCount);
+	}
+
+	size_t usdVertexCount = usdSkin.jointIndices.size() / usdSkin.elementSize;
+	if (usdVertexCount != mayaVertexCount) return -1;
+
+	return static_cast<long long>(usdVertexCount);
+}
+
+// Reads the weights of a skin cluster straight from its weightList[v].weights[j] plugs.
+// Only the entries Maya stores are visited, where getWeights pads every vertex out to
+// every influence, so the cost follows the non-zero weights. Entries are stored as
+// slotJoints[slot], or the influenceObjects() slot without it, and rows are sorted by
+// them. Returns false when the plugs cannot be read this way, the skin cluster then has
+// to go through getWeights.
+bool readSparseSkinWeights(const MFnSkinCluster& skinCluster, const MDagPathArray& influencePaths,
+	const std::vector<int>* slotJoints, unsigned int vertexCount, ValidateRigCmd::MayaSkinBindingData& data)
+{
+	MStatus status;
+
+	// weightList only holds the weights of the first deformed shape
+	if (skinCluster.numOutputConnections() != 1) return false;
+
+	// weights[] is indexed by the logical index of the influence's matrix plug. A joint
+	// outside the skeleton is stored as -1, logical indices of no influence are skipped.
+	const int kNoInfluence = -2;
+	std::vector<int> jointByLogicalIndex;
+	for (unsigned int i = 0; i < influencePaths.length(); ++i) {
+		unsigned int logicalIndex = skinCluster.indexForInfluenceObject(influencePaths[i], &status);
+		if (status != MS::kSuccess) return false;
+		if (logicalIndex >= jointByLogicalIndex.size()) {
+			jointByLogicalIndex.resize(logicalIndex + 1, kNoInfluence);
+		}
+		jointByLogicalIndex[logicalIndex] = slotJoints ? (*slotJoints)[i] : static_cast<int>(i);
+	}
+
+	MPlug weightListPlug = skinCluster.findPlug("weightList", true, &status);
+	if (status != MS::kSuccess) return false;
+	MObject weightsAttr = skinCluster.attribute("weights", &status);
+	if (status != MS::kSuccess) return false;
+
+	MIntArray vertices;
+	weightListPlug.getExistingArrayAttributeIndices(vertices, &status);
+	if (status != MS::kSuccess) return false;
+
+	// Most vertices carry a few influences, grown like the getWeights path when they do not
+	data.jointIndices.setLength(vertexCount * 4);
+	data.jointWeights.setLength(vertexCount * 4);
+	data.vertexOffsets.setLength(vertexCount + 1);
+
+	unsigned int arrayIndex = 0;
+	unsigned int nextVertex = 0;
+	MIntArray influenceIndices;
+	for (unsigned int e = 0; e < vertices.length(); ++e) {
+		// Existing indices come back in ascending order
+		unsigned int vertex = static_cast<unsigned int>(vertices[e]);
+		if (vertex >= vertexCount) break;
+		if (vertex < nextVertex) return false;
+
+		// Vertices without a weightList element have no weights
+		while (nextVertex <= vertex) {
+			data.vertexOffsets[nextVertex++] = arrayIndex;
+		}
+
+		MPlug weightsPlug = weightListPlug.elementByLogicalIndex(vertex).child(weightsAttr);
+		weightsPlug.getExistingArrayAttributeIndices(influenceIndices);
+		unsigned int rowBegin = arrayIndex;
+		for (unsigned int j = 0; j < influenceIndices.length(); ++j) {
+			unsigned int logicalIndex = static_cast<unsigned int>(influenceIndices[j]);
+			if (logicalIndex >= jointByLogicalIndex.size() || jointByLogicalIndex[logicalIndex] == kNoInfluence) continue;
+
+			double weight = weightsPlug.elementByLogicalIndex(logicalIndex).asDouble();
+			if (weight <= kWeightPruneThreshold) continue;
+
+			if (arrayIndex >= data.jointIndices.length()) {
+				data.jointIndices.setLength(data.jointIndices.length() + vertexCount);
+				data.jointWeights.setLength(data.jointWeights.length() + vertexCount);
+			}
+
+			// Insertion into joint order, a row only holds a handful of entries
+			int joint = jointByLogicalIndex[logicalIndex];
+			unsigned int k = arrayIndex++;
+			for (; k > rowBegin && data.jointIndices[k - 1] > joint; --k) {
+				data.jointIndices[k] = data.jointIndices[k - 1];
+				data.jointWeights[k] = data.jointWeights[k - 1];
+			}
+			data.jointIndices[k] = joint;
+			data.jointWeights[k] = static_cast<float>(weight);
+		}
+	}
+	while (nextVertex <= vertexCount) {
+		data.vertexOffsets[nextVertex++] = arrayIndex;
+	}
+
+	data.jointIndices.setLength(arrayIndex);
+	data.jointWeights.setLength(arrayIndex);
+	return true;
+}
+
+}
 
 ValidateRigCmd::ValidateRigCmd() {
 	ValidateRigCmd::m_usdFilePath = "";
+	ValidateRigCmd::m_incremental = false;
+	ValidateRigCmd::m_async = false;
+	ValidateRigCmd::m_animated = false;
+	ValidateRigCmd::m_startFrame = 0.0;
+	ValidateRigCmd::m_endFrame = 0.0;
+	ValidateRigCmd::m_frameStep = 1.0;
+	ValidateRigCmd::m_reportPath = "";
+	ValidateRigCmd::m_maxSamples = IssueSink::kDefaultSampleLimit;
+	ValidateRigCmd::m_streamSkins = false;
+	ValidateRigCmd::m_compact = false;
+	ValidateRigCmd::m_matchSkeletons = false;
 }
 
 ValidateRigCmd::~ValidateRigCmd() {
@@ -55,14 +515,451 @@ MSyntax ValidateRigCmd::newSyntax() {
 	MSyntax syntax;
 	syntax.addFlag(rootFlag, rootFlagLong, MSyntax::kString);
 	syntax.addFlag(pathFlag, pathFlagLong, MSyntax::kString);
+	syntax.addFlag(incrementalFlag, incrementalFlagLong);
+	syntax.addFlag(clearSessionFlag, clearSessionFlagLong);
+	syntax.addFlag(asyncFlag, asyncFlagLong);
+	syntax.addFlag(jobStatusFlag, jobStatusFlagLong, MSyntax::kLong);
+	syntax.addFlag(progressFlag, progressFlagLong, MSyntax::kLong);
+	syntax.addFlag(cancelFlag, cancelFlagLong, MSyntax::kLong);
+	syntax.addFlag(resultFlag, resultFlagLong, MSyntax::kLong);
+	syntax.addFlag(frameRangeFlag, frameRangeFlagLong, MSyntax::kDouble, MSyntax::kDouble);
+	syntax.addFlag(frameStepFlag, frameStepFlagLong, MSyntax::kDouble);
+	syntax.addFlag(reportFlag, reportFlagLong, MSyntax::kString);
+	syntax.addFlag(maxSamplesFlag, maxSamplesFlagLong, MSyntax::kLong);
+	syntax.addFlag(manifestFlag, manifestFlagLong, MSyntax::kString);
+	syntax.addFlag(resultCacheFlag, resultCacheFlagLong, MSyntax::kString);
+	syntax.addFlag(streamSkinsFlag, streamSkinsFlagLong);
+	syntax.addFlag(compactFlag, compactFlagLong);
+	syntax.addFlag(matchSkeletonsFlag, matchSkeletonsFlagLong);
+	syntax.addFlag(linearToleranceFlag, linearToleranceFlagLong, MSyntax::kDouble, MSyntax::kDouble, MSyntax::kLong);
+	syntax.addFlag(translationToleranceFlag, translationToleranceFlagLong, MSyntax::kDouble, MSyntax::kDouble, MSyntax::kLong);
+	syntax.addFlag(scaleToleranceFlag, scaleToleranceFlagLong, MSyntax::kDouble, MSyntax::kDouble, MSyntax::kLong);
+	syntax.addFlag(rotationToleranceFlag, rotationToleranceFlagLong, MSyntax::kDouble);
 
 	return syntax;
 }
 
 MStatus ValidateRigCmd::doIt(const MArgList& arg) {
+	MStatus status;
+	MArgDatabase argData(syntax(), arg, &status);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+
+	if (argData.isFlagSet(jobStatusFlag) || argData.isFlagSet(progressFlag) ||
+		argData.isFlagSet(cancelFlag) || argData.isFlagSet(resultFlag)) {
+		return doJobQuery(argData);
+	}
+
+	if (argData.isFlagSet(clearSessionFlag)) {
+		clearSession();
+		if (!argData.isFlagSet(rootFlag)) return MS::kSuccess;
+	}
+
+	status = parseArgs(argData);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+
+	// Scratch buffers of this run, all released together when doIt returns
+	RunArena arena;
+	RunArena::Scope arenaScope(arena);
+	TolerancePolicy::Scope toleranceScope(m_tolerance);
+
+	if (m_manifestPath.length() > 0 || m_matchSkeletons) {
+		return doBatch();
+	}
+
+	if (m_async) {
+		// Hand back a job handle right away, the work continues on idle events and workers
+		int jobId = s_nextJobId++;
+		auto job = std::make_unique<ValidationJob>(jobId, m_root, m_usdFilePath, m_maxSamples);
+		status = job->start();
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+
+		s_jobs[jobId] = std::move(job);
+		setResult(jobId);
+		return MS::kSuccess;
+	}
+
+	// With -report the issues go straight to the file instead of the script editor
+	std::unique_ptr<ReportWriter> writer;
+	if (m_reportPath.length() > 0) {
+		writer = ReportWriter::create(m_reportPath);
+		if (!writer) {
+			MGlobal::displayError("Could not open report file: " + m_reportPath);
+			return MS::kFailure;
+		}
+		writer->setSampleLimit(m_maxSamples);
+	}
+
+	MString rootName = MFnDagNode(m_root).name();
+	BoundedIssueSink issues(m_maxSamples);
+	std::unique_ptr<USDRigData> parsedUsdRig;
+	std::unique_ptr<MayaRigData> parsedMayaRig;
+	const USDRigData* usdRig = nullptr;
+	const MayaRigData* mayaRig = nullptr;
+	if (m_incremental) {
+		// Reuse the resident session when it was built for the same pair
+		if (!s_session || !s_session->matches(m_root, m_usdFilePath)) {
+			s_session = std::make_unique<ValidationSession>(m_root, m_usdFilePath);
+		}
+		status = s_session->revalidate(m_maxSamples);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+		usdRig = s_session->usdRig();
+		mayaRig = s_session->mayaRig();
+
+		IssueSink* sink = &issues;
+		if (writer) {
+			writer->writeHeader(m_usdFilePath, rootName, mayaRig->geomNames);
+			sink = writer.get();
+		}
+
+		s_session->collectIssues(*sink);
+	}
+	else {
+		// USD is thread safe. Without a cache to consult first the rig is read on a worker
+		// while the main thread extracts the Maya side, the two meet at the comparison.
+		ValidationLog::Buffer usdMessages;
+		std::future<std::unique_ptr<USDRigData>> usdFuture;
+		if (m_resultCachePath.length() == 0) {
+			usdFuture = std::async(std::launch::async, [this, rootName, &usdMessages]() {
+				ValidationLog::ScopedThreadBuffer logScope(&usdMessages);
+				TolerancePolicy::Scope toleranceScope(m_tolerance);
+				return parseUSDRig(m_usdFilePath, rootName, m_streamSkins);
+			});
+		}
+
+		parsedMayaRig = parseMayaRig(m_root, m_compact);
+		if (!parsedMayaRig) {
+			if (usdFuture.valid()) usdFuture.wait();
+			usdMessages.flush();
+			return MS::kFailure;
+		}
+		mayaRig = parsedMayaRig.get();
+
+		// The key only needs the Maya rig and the layer files, a hit skips parsing USD
+		std::unique_ptr<ResultCache> cache;
+		std::string cacheKey;
+		bool cached = false;
+		if (m_resultCachePath.length() > 0) {
+			cache = std::make_unique<ResultCache>(m_resultCachePath);
+			cacheKey = cache->key(m_usdFilePath, *mayaRig,
+				cacheSettings(m_maxSamples, m_animated, m_startFrame, m_endFrame, m_frameStep));
+			cached = cache->lookup(cacheKey, issues);
+		}
+
+		if (writer) {
+			writer->writeHeader(m_usdFilePath, rootName, mayaRig->geomNames);
+		}
+
+		if (cached) {
+			MGlobal::displayInfo("Rig validation result taken from the cache");
+			if (writer) writer->merge(issues);
+		}
+		else {
+			if (usdFuture.valid()) {
+				parsedUsdRig = usdFuture.get();
+				usdMessages.flush();
+			}
+			else {
+				parsedUsdRig = parseUSDRig(m_usdFilePath, rootName, m_streamSkins);
+			}
+			if (!parsedUsdRig) return MS::kFailure;
+			usdRig = parsedUsdRig.get();
+
+			// The summary is still needed for the cache when a writer takes the issues
+			IssueSink* sink = &issues;
+			std::unique_ptr<TeeIssueSink> tee;
+			if (writer) {
+				if (cache) {
+					tee = std::make_unique<TeeIssueSink>(issues, *writer);
+					sink = tee.get();
+				}
+				else {
+					sink = writer.get();
+				}
+			}
+
+			validateRig(*usdRig, *mayaRig, *sink);
+
+			if (m_animated) {
+				validateAnimation(m_usdFilePath, usdRig->skeleton, mayaRig->skeleton,
+					m_startFrame, m_endFrame, m_frameStep, *sink);
+			}
+
+			if (cache) {
+				cache->store(cacheKey, issues);
+				cache->trimIfDue();
+			}
+		}
+	}
+
+	if (writer) {
+		unsigned int issueCount = static_cast<unsigned int>(writer->issueCount());
+		if (!writer->close()) {
+			MGlobal::displayError("Failed to write report file: " + m_reportPath);
+			return MS::kFailure;
+		}
+
+		MGlobal::displayInfo(MString("Rig validation wrote ") + issueCount + " issue(s) to " + m_reportPath);
+		setResult(issueCount == 0);
+		return MS::kSuccess;
+	}
+
+	reportIssues(issues, usdRig, mayaRig);
+	setResult(issues.empty());
+
+	return MS::kSuccess;
+}
+
+MStatus ValidateRigCmd::parseArgs(const MArgDatabase& argData) {
+	MStatus status;
+
+	m_manifestPath = "";
+	m_matchSkeletons = argData.isFlagSet(matchSkeletonsFlag);
+	if (m_matchSkeletons) {
+		// Every skeleton of the file against every root joint of the scene, run as a batch
+		if (!argData.isFlagSet(pathFlag) || argData.isFlagSet(rootFlag) || argData.isFlagSet(manifestFlag) ||
+			argData.isFlagSet(incrementalFlag) || argData.isFlagSet(asyncFlag)) {
+			MGlobal::displayError("-matchSkeletons needs -usdFile and cannot be combined with -root, -manifest, -incremental or -async");
+			return MS::kInvalidParameter;
+		}
+		argData.getFlagArgument(pathFlag, 0, m_usdFilePath);
+	}
+	else if (argData.isFlagSet(manifestFlag)) {
+		if (argData.isFlagSet(rootFlag) || argData.isFlagSet(pathFlag) ||
+			argData.isFlagSet(incrementalFlag) || argData.isFlagSet(asyncFlag)) {
+			MGlobal::displayError("-manifest cannot be combined with -root, -usdFile, -incremental or -async");
+			return MS::kInvalidParameter;
+		}
+		argData.getFlagArgument(manifestFlag, 0, m_manifestPath);
+	}
+	else if (!argData.isFlagSet(rootFlag) || !argData.isFlagSet(pathFlag)) {
+		MGlobal::displayError("validateRig requires both -root and -usdFile, or -manifest");
+		return MS::kInvalidParameter;
+	}
+	else {
+		MString rootName;
+		argData.getFlagArgument(rootFlag, 0, rootName);
+		MSelectionList selection;
+		status = selection.add(rootName);
+		if (status != MS::kSuccess || selection.getDagPath(0, m_root) != MS::kSuccess) {
+			MGlobal::displayError("Root joint not found: " + rootName);
+			return MS::kInvalidParameter;
+		}
+
+		argData.getFlagArgument(pathFlag, 0, m_usdFilePath);
+	}
+
+	m_incremental = argData.isFlagSet(incrementalFlag);
+	m_async = argData.isFlagSet(asyncFlag);
+	if (m_incremental && m_async) {
+		MGlobal::displayError("-incremental and -async cannot be combined");
+		return MS::kInvalidParameter;
+	}
+
+	m_animated = argData.isFlagSet(frameRangeFlag);
+	if (m_animated) {
+		if (m_incremental || m_async) {
+			MGlobal::displayError("-frameRange cannot be combined with -incremental or -async");
+			return MS::kInvalidParameter;
+		}
+		argData.getFlagArgument(frameRangeFlag, 0, m_startFrame);
+		argData.getFlagArgument(frameRangeFlag, 1, m_endFrame);
+		if (argData.isFlagSet(frameStepFlag)) {
+			argData.getFlagArgument(frameStepFlag, 0, m_frameStep);
+		}
+		if (m_endFrame < m_startFrame || m_frameStep <= 0.0) {
+			MGlobal::displayError("-frameRange needs start <= end and a positive -frameStep");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	m_reportPath = "";
+	if (argData.isFlagSet(reportFlag)) {
+		if (m_async) {
+			MGlobal::displayError("-report cannot be combined with -async");
+			return MS::kInvalidParameter;
+		}
+		argData.getFlagArgument(reportFlag, 0, m_reportPath);
+	}
+
+	if (argData.isFlagSet(maxSamplesFlag)) {
+		argData.getFlagArgument(maxSamplesFlag, 0, m_maxSamples);
+		if (m_maxSamples < 0) {
+			MGlobal::displayError("-maxSamples cannot be negative");
+			return MS::kInvalidParameter;
+		}
+	}
+
+	m_resultCachePath = "";
+	if (argData.isFlagSet(resultCacheFlag)) {
+		// Both keep state that outlives the scene contents a cache key is taken from
+		if (m_incremental || m_async) {
+			MGlobal::displayError("-resultCache cannot be combined with -incremental or -async");
+			return MS::kInvalidParameter;
+		}
+		argData.getFlagArgument(resultCacheFlag, 0, m_resultCachePath);
+	}
+
+	m_streamSkins = argData.isFlagSet(streamSkinsFlag);
+	if (m_streamSkins && (m_incremental || m_async)) {
+		MGlobal::displayError("-streamSkins cannot be combined with -incremental or -async");
+		return MS::kInvalidParameter;
+	}
+
+	// Incremental sessions update the double transforms in place, and a cache key taken
+	// from float copies would miss changes below float resolution
+	m_compact = argData.isFlagSet(compactFlag);
+	if (m_compact && (m_incremental || m_async || m_resultCachePath.length() > 0)) {
+		MGlobal::displayError("-compact cannot be combined with -incremental, -async or -resultCache");
+		return MS::kInvalidParameter;
+	}
+
+	// Sessions and jobs compare after the command returns, always with the defaults
+	m_tolerance = TolerancePolicy();
+	bool linearTolerance = argData.isFlagSet(linearToleranceFlag);
+	bool translationTolerance = argData.isFlagSet(translationToleranceFlag);
+	bool scaleTolerance = argData.isFlagSet(scaleToleranceFlag);
+	bool rotationTolerance = argData.isFlagSet(rotationToleranceFlag);
+	if ((linearTolerance || translationTolerance || scaleTolerance || rotationTolerance) && (m_incremental || m_async)) {
+		MGlobal::displayError("Tolerance flags cannot be combined with -incremental or -async");
+		return MS::kInvalidParameter;
+	}
+	if (linearTolerance) {
+		status = readToleranceBounds(argData, linearToleranceFlag, m_tolerance.linear);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+	}
+	if (translationTolerance) {
+		status = readToleranceBounds(argData, translationToleranceFlag, m_tolerance.translation);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+	}
+	if (scaleTolerance) {
+		status = readToleranceBounds(argData, scaleToleranceFlag, m_tolerance.scale);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+	}
+	if (rotationTolerance) {
+		// Given in degrees like Maya's rotate channels
+		double degrees = 0.0;
+		argData.getFlagArgument(rotationToleranceFlag, 0, degrees);
+		if (degrees < 0.0) {
+			MGlobal::displayError("-rotationTolerance cannot be negative");
+			return MS::kInvalidParameter;
+		}
+		m_tolerance.rotation = degrees / kDegreesPerRadian;
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus ValidateRigCmd::doJobQuery(const MArgDatabase& argData) {
+	const char* flag = argData.isFlagSet(jobStatusFlag) ? jobStatusFlag :
+		argData.isFlagSet(progressFlag) ? progressFlag :
+		argData.isFlagSet(cancelFlag) ? cancelFlag : resultFlag;
+
+	int jobId = 0;
+	argData.getFlagArgument(flag, 0, jobId);
+	auto it = s_jobs.find(jobId);
+	if (it == s_jobs.end()) {
+		MGlobal::displayError(MString("No validation job with handle ") + jobId);
+		return MS::kInvalidParameter;
+	}
+
+	ValidationJob& job = *it->second;
+	job.flushMessages();
+
+	if (flag == jobStatusFlag) {
+		setResult(MString(ValidationJob::stateName(job.state())));
+	}
+	else if (flag == progressFlag) {
+		setResult(job.progress());
+	}
+	else if (flag == cancelFlag) {
+		job.cancel();
+	}
+	else {
+		if (job.state() == ValidationJob::State::RUNNING) {
+			MGlobal::displayError(MString("Validation job ") + jobId + " is still running");
+			return MS::kFailure;
+		}
+
+		MStringArray descriptions;
+		if (job.state() == ValidationJob::State::DONE) {
+			reportIssues(job.issues(), job.usdRig(), job.mayaRig());
+			descriptions = describeIssues(job.issues(), job.usdRig(), job.mayaRig());
+		}
+		else {
+			MGlobal::displayWarning(MString("Validation job ") + jobId + " " +
+				ValidationJob::stateName(job.state()));
+		}
+		setResult(descriptions);
+
+		// Results are handed out once
+		s_jobs.erase(it);
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus ValidateRigCmd::doBatch() {
+	MStatus status;
+
+	ValidationBatch batch(m_maxSamples);
+	status = m_matchSkeletons ? batch.matchSkeletons(m_usdFilePath) : batch.loadManifest(m_manifestPath);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+	if (m_animated) {
+		batch.setFrameRange(m_startFrame, m_endFrame, m_frameStep);
+	}
+	batch.setStreamSkins(m_streamSkins);
+	batch.setCompact(m_compact);
+
+	std::unique_ptr<ReportWriter> writer;
+	if (m_reportPath.length() > 0) {
+		writer = ReportWriter::create(m_reportPath);
+		if (!writer) {
+			MGlobal::displayError("Could not open report file: " + m_reportPath);
+			return MS::kFailure;
+		}
+		writer->setSampleLimit(m_maxSamples);
+	}
+
+	std::unique_ptr<ResultCache> cache;
+	if (m_resultCachePath.length() > 0) {
+		cache = std::make_unique<ResultCache>(m_resultCachePath);
+		batch.setResultCache(cache.get(),
+			cacheSettings(m_maxSamples, m_animated, m_startFrame, m_endFrame, m_frameStep));
+	}
+
+	status = batch.run(writer.get());
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+
+	if (writer && !writer->close()) {
+		MGlobal::displayError("Failed to write report file: " + m_reportPath);
+		return MS::kFailure;
+	}
+
+	setResult(batch.numFailed() == 0);
 	return MS::kSuccess;
 }
 
+std::vector<double> ValidateRigCmd::cacheSettings(int sampleLimit, bool animated,
+	double startFrame, double endFrame, double frameStep) {
+	std::vector<double> settings = {
+		kWeightTolerance, kWeightPruneThreshold, kAnimationTolerance,
+		static_cast<double>(sampleLimit)
+	};
+	TolerancePolicy::current().appendSettings(settings);
+	if (animated) {
+		settings.insert(settings.end(), { startFrame, endFrame, frameStep });
+	}
+	return settings;
+}
+
+void ValidateRigCmd::clearSession() {
+	s_session.reset();
+}
+
+void ValidateRigCmd::clearJobs() {
+	s_jobs.clear();
+}
+
 MStatus ValidateRigCmd::redoIt() {
 	return MS::kSuccess;
 }
@@ -75,25 +972,35 @@ bool ValidateRigCmd::isUndoable() const {
 	return false;
 }
 
-std::unique_ptr<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseUSDSkelData(const MString& filePath, const SdfPath& skelPath)
+UsdStageRefPtr ValidateRigCmd::openUSDStage(const MString& filePath)
 {
 	UsdStageRefPtr stage = UsdStage::Open(filePath.asChar(), UsdStage::LoadAll);
 	if (!stage) {
-		MGlobal::displayError("Failed to open USD file: " + filePath);
-		return nullptr;
+		ValidationLog::error("Failed to open USD file: " + filePath);
 	}
+	return stage;
+}
+
+std::unique_ptr<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseUSDSkelData(const MString& filePath, const SdfPath& skelPath)
+{
+	UsdStageRefPtr stage = openUSDStage(filePath);
+	if (!stage) return nullptr;
+	return parseUSDSkelData(stage, skelPath);
+}
 
+std::unique_ptr<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseUSDSkelData(const UsdStageRefPtr& stage, const SdfPath& skelPath)
+{
 	// Get the skeleton prim
 	UsdPrim skelPrim = stage->GetPrimAtPath(skelPath);
 	if (!skelPrim.IsValid()) {
-		MGlobal::displayError("Invalid skeleton path: " + MString(skelPath.GetText()));
+		ValidationLog::error("Invalid skeleton path: " + MString(skelPath.GetText()));
 		return nullptr;
 	}
 
 	// Create UsdSkelSkeleton shema
 	UsdSkelSkeleton skeleton(skelPrim);
 	if (!skeleton) {
-		MGlobal::displayError("Prim is not a valid UsdSkelSkeleton: " + MString(skelPath.GetText()));
+		ValidationLog::error("Prim is not a valid UsdSkelSkeleton: " + MString(skelPath.GetText()));
 		return nullptr;
 	}
 
@@ -104,10 +1011,17 @@ std::unique_ptr<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseUSDSkelDat
 	// Extract joint names
 	UsdAttribute jointsAttr = skeleton.GetJointsAttr();
 	if (!jointsAttr.Get(&skelData->jointNames)) {
-		MGlobal::displayError("Failed to read joints attribute");
+		ValidationLog::error("Failed to read joints attribute");
 		return nullptr;
 	}
 
+	std::vector<std::string> jointPaths;
+	jointPaths.reserve(skelData->jointNames.size());
+	for (const TfToken& jointName : skelData->jointNames) {
+		jointPaths.push_back(JointPathTable::normalize(jointName.GetString()));
+	}
+	JointPathTable::instance().intern(jointPaths, skelData->jointIds);
+
 	// Extract joint parent indices
 	UsdSkelTopology topology(skelData->jointNames);
 	VtIntArray parentIndices = topology.GetParentIndices();
@@ -116,14 +1030,14 @@ std::unique_ptr<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseUSDSkelDat
 	// Extract bind transforms
 	UsdAttribute bindTransformsAttr = skeleton.GetBindTransformsAttr();
 	if (!bindTransformsAttr.Get(&skelData->bindTransforms)) {
-		MGlobal::displayError("Failed to read bind transforms");
+		ValidationLog::error("Failed to read bind transforms");
 		return nullptr;
 	}
 
 	// Extract rest transforms
 	UsdAttribute restTransformsAttr = skeleton.GetRestTransformsAttr();
 	if (!restTransformsAttr.Get(&skelData->restTransforms)) {
-		MGlobal::displayError("Failed to read rest transforms");
+		ValidationLog::error("Failed to read rest transforms");
 		return nullptr;
 	}
 
@@ -132,68 +1046,199 @@ std::unique_ptr<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseUSDSkelDat
 	if (skelData->jointParentIndices.size() != numJoints ||
 		skelData->bindTransforms.size() != numJoints ||
 		skelData->restTransforms.size() != numJoints) {
-		MGlobal::displayError("Inconsistent skeleton data sizes");
+		ValidationLog::error("Inconsistent skeleton data sizes");
 		return nullptr;
 	}
 
+	hashSubtrees(*skelData, TolerancePolicy::current(), skelData->subtrees);
+
 	return skelData;
 }
 
 std::vector<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseAllUSDSkels(const MString& filePath)
+{
+	UsdStageRefPtr stage = openUSDStage(filePath);
+	if (!stage) return std::vector<USDSkeletonData>();
+	return parseAllUSDSkels(stage, filePath);
+}
+
+std::vector<ValidateRigCmd::USDSkeletonData> ValidateRigCmd::parseAllUSDSkels(const UsdStageRefPtr& stage, const MString& filePath)
 {
 	std::vector<USDSkeletonData> skeletons;
 
-	// Open the USD stage
-	UsdStageRefPtr stage = UsdStage::Open(filePath.asChar());
-	if (!stage) {
-		MGlobal::displayError("Failed to open USD file: " + filePath);
-		return skeletons;
+	// Find all UsdSkelSkeleton prims, in path order
+	SkelPrimIndex skelPrims;
+	skelPrims.build(stage);
+	for (const SdfPath& skelPath : skelPrims.skeletons()) {
+		// Parse this skeleton
+		auto skelData = parseUSDSkelData(stage, skelPath);
+		if (skelData) {
+			skeletons.push_back(std::move(*skelData));
+		}
+		else {
+			ValidationLog::warning("Failed to parse skeleton at path: " +
+				MString(skelPath.GetText()));
+		}
+	}
+
+	if (skeletons.empty()) {
+		ValidationLog::warning("No UsdSkelSkeleton prims found in file: " + filePath);
+	}
+	else {
+		ValidationLog::info(MString("Found ") + skeletons.size() +
+			" skeleton(s) in file: " + filePath);
 	}
 
-	// Traverse the stage to find all UsdSkelSkeleton prims
-	UsdPrimRange primRange = stage->Traverse();
-	for (UsdPrim prim : primRange) {
-		if (prim.IsA<UsdSkelSkeleton>()) {
-			SdfPath skelPath = prim.GetPath();
+	return skeletons;
+}
 
-			// Parse this skeleton
-			auto skelData = parseUSDSkelData(filePath, skelPath);
-			if (skelData) {
-				skeletons.push_back(std::move(*skelData));
+std::vector<ValidateRigCmd::USDSkinBindingData> ValidateRigCmd::parseUSDSkinBindings(const UsdStageRefPtr& stage,
+	const SdfPath& skelPath, bool deferWeights)
+{
+	std::vector<USDSkinBindingData> bindings;
+
+	// Skeleton joint by name, for bindings that index their own skel:joints list
+	std::unordered_map<TfToken, int, TfToken::HashFunctor> skeletonJointIndices;
+	bool skeletonJointsRead = false;
+
+	SkelPrimIndex skelPrims;
+	skelPrims.build(stage);
+	for (const SdfPath& primPath : skelPrims.boundPrims()) {
+		UsdPrim prim = stage->GetPrimAtPath(primPath);
+		UsdSkelBindingAPI bindingAPI(prim);
+		UsdGeomPrimvar jointIndicesPrimvar = bindingAPI.GetJointIndicesPrimvar();
+		UsdGeomPrimvar jointWeightsPrimvar = bindingAPI.GetJointWeightsPrimvar();
+		if (!jointIndicesPrimvar.HasAuthoredValue() || !jointWeightsPrimvar.HasAuthoredValue()) continue;
+
+		// Only geometry bound to this skeleton, the binding may be inherited from a SkelRoot
+		UsdSkelSkeleton skeleton = bindingAPI.GetInheritedSkeleton();
+		if (!skeleton || skeleton.GetPrim().GetPath() != skelPath) continue;
+
+		USDSkinBindingData binding;
+		binding.skelPath = skelPath;
+		binding.geomPath = prim.GetPath();
+		binding.elementSize = jointIndicesPrimvar.GetElementSize();
+		binding.constant = jointIndicesPrimvar.GetInterpolation() == UsdGeomTokens->constant;
+
+		// jointIndices then refer to entries of skel:joints, remapped to skeleton order on read
+		VtTokenArray bindingJoints;
+		UsdAttribute bindingJointsAttr = bindingAPI.GetJointsAttr();
+		if (bindingJointsAttr.HasAuthoredValue() && bindingJointsAttr.Get(&bindingJoints)) {
+			if (!skeletonJointsRead) {
+				VtTokenArray skeletonJoints;
+				skeleton.GetJointsAttr().Get(&skeletonJoints);
+				for (size_t j = 0; j < skeletonJoints.size(); ++j) {
+					skeletonJointIndices.emplace(skeletonJoints[j], static_cast<int>(j));
+				}
+				skeletonJointsRead = true;
 			}
-			else {
-				MGlobal::displayWarning("Failed to parse skeleton at path: " +
-					MString(skelPath.GetText()));
+
+			binding.jointRemap.resize(bindingJoints.size(), -1);
+			for (size_t j = 0; j < bindingJoints.size(); ++j) {
+				auto it = skeletonJointIndices.find(bindingJoints[j]);
+				if (it != skeletonJointIndices.end()) {
+					binding.jointRemap[j] = it->second;
+				}
 			}
 		}
+
+		binding.weightsDeferred = deferWeights;
+		if (!deferWeights && !readUSDSkinWeights(prim, binding)) {
+			ValidationLog::warning("Failed to read skinning primvars: " + MString(prim.GetPath().GetText()));
+			continue;
+		}
+
+		// Geometry bind transform falls back to identity when not authored
+		binding.geomBindTransform.SetIdentity();
+		bindingAPI.GetGeomBindTransformAttr().Get(&binding.geomBindTransform);
+
+		bindings.push_back(std::move(binding));
 	}
 
-	if (skeletons.empty()) {
-		MGlobal::displayWarning("No UsdSkelSkeleton prims found in file: " + filePath);
+	return bindings;
+}
+
+bool ValidateRigCmd::readUSDSkinWeights(const UsdPrim& prim, USDSkinBindingData& binding)
+{
+	// Unindexed primvars come back as the attribute's own array. From .usdc layers USD maps
+	// large arrays straight from the file instead of copying them, so pages are faulted in
+	// as the comparison walks the vertex chunks and can be dropped again behind it.
+	UsdSkelBindingAPI bindingAPI(prim);
+	if (!bindingAPI.GetJointIndicesPrimvar().ComputeFlattened(&binding.jointIndices) ||
+		!bindingAPI.GetJointWeightsPrimvar().ComputeFlattened(&binding.jointWeights)) {
+		return false;
 	}
-	else {
-		MGlobal::displayInfo(MString("Found ") + skeletons.size() +
-			" skeleton(s) in file: " + filePath);
+
+	// Into skeleton order once here, so the comparison reads both sides index for index.
+	// Entries naming no skeleton joint become -1 and mismatch whatever Maya has.
+	if (!binding.jointRemap.empty()) {
+		const std::vector<int>& remap = binding.jointRemap;
+		for (int& jointIndex : binding.jointIndices) {
+			jointIndex = jointIndex >= 0 && static_cast<size_t>(jointIndex) < remap.size() ? remap[jointIndex] : -1;
+		}
 	}
+	return true;
+}
 
-	return skeletons;
+std::unique_ptr<ValidateRigCmd::USDRigData> ValidateRigCmd::parseUSDRig(const MString& filePath, const MString& rootName,
+	bool streamSkins, const SdfPath& skelPath)
+{
+	UsdStageRefPtr stage = openUSDStage(filePath);
+	if (!stage) return nullptr;
+	return parseUSDRig(stage, filePath, rootName, streamSkins, skelPath);
 }
 
-std::unique_ptr<ValidateRigCmd::MayaSkeletonData> ValidateRigCmd::parseMayaSkel(const MDagPath& root)
+std::unique_ptr<ValidateRigCmd::USDRigData> ValidateRigCmd::parseUSDRig(const UsdStageRefPtr& stage, const MString& filePath,
+	const MString& rootName, bool streamSkins, const SdfPath& skelPath)
 {
-	MStatus status;
+	auto rigData = std::make_unique<USDRigData>();
 
-	// Verify that root is a joint
-	if (!root.hasFn(MFn::kJoint)) {
-		MGlobal::displayError("Root path is not a joint");
-		return nullptr;
+	// Already paired with the root, e.g. by SkeletonMatcher, only that skeleton is read
+	if (!skelPath.IsEmpty()) {
+		auto skelData = parseUSDSkelData(stage, skelPath);
+		if (!skelData) return nullptr;
+		rigData->skeleton = std::move(*skelData);
+	}
+	else {
+		std::vector<USDSkeletonData> skeletons = parseAllUSDSkels(stage, filePath);
+		if (skeletons.empty()) return nullptr;
+
+		// Pick the skeleton whose first joint carries the Maya root's name, a lone skeleton always matches
+		size_t match = skeletons.size();
+		std::string rootJointName = JointPathTable::stripNamespace(rootName.asChar());
+		for (size_t i = 0; i < skeletons.size() && match == skeletons.size(); ++i) {
+			const VtTokenArray& jointNames = skeletons[i].jointNames;
+			if (!jointNames.empty() && SdfPath(jointNames[0].GetString()).GetName() == rootJointName) {
+				match = i;
+			}
+		}
+		if (match == skeletons.size()) {
+			if (skeletons.size() > 1) {
+				ValidationLog::error("No USD skeleton has a root joint named " + rootName);
+				return nullptr;
+			}
+			match = 0;
+		}
+		rigData->skeleton = std::move(skeletons[match]);
 	}
 
-	auto skelData = std::make_unique<MayaSkeletonData>();
-	skelData->rootPath = root;
+	rigData->skinBindings = parseUSDSkinBindings(stage, rigData->skeleton.primPath, streamSkins);
+
+	// Only one mesh's weights are held at a time, read from the stage as each is validated
+	if (streamSkins) {
+		rigData->stage = stage;
+	}
+
+	return rigData;
+}
+
+std::unique_ptr<ValidateRigCmd::MayaSkeletonData> ValidateRigCmd::parseMayaSkel(const MDagPath& root, bool compact)
+{
+	MStatus status;
 
-	std::vector<MDagPath> jointPaths;
-	std::map<std::string, int> jointNameToIndex;
+	auto skelData = std::make_unique<MayaSkeletonData>();
+	status = parseMayaJointHierarchy(root, *skelData);
+	if (status != MS::kSuccess) return nullptr;
 
 	// Get root world matrix, used for rest transform calculation
 	MMatrix rootWorldMatrix = root.inclusiveMatrix(&status);
@@ -203,127 +1248,199 @@ std::unique_ptr<ValidateRigCmd::MayaSkeletonData> ValidateRigCmd::parseMayaSkel(
 	}
 	MMatrix rootWorldInverse = rootWorldMatrix.inverse();
 
-	// Recursively traverse the joint hierarchy
-	std::function<void(const MDagPath&)> traverseJoints = [&](const MDagPath dagPath) {
-		MFnDagNode dagNode(dagPath, &status);
-		if (status != MS::kSuccess) return;
+	unsigned int numJoints = skelData->jointPaths.length();
+	if (compact) {
+		skelData->compact = true;
+		skelData->rootWorldInverse = rootWorldInverse;
+		skelData->compactBindTransforms.resize(numJoints);
+		skelData->compactRestTransforms.resize(numJoints);
+	}
+
+	// Extract rest and bind transforms for each joint
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		MMatrix restTransform, bindTransform;
+		status = parseMayaJoint(skelData->jointPaths[i], rootWorldInverse, restTransform, bindTransform);
+		if (status != MS::kSuccess) return nullptr;
+
+		if (compact) {
+			skelData->compactRestTransforms.set(i, restTransform);
+			skelData->compactBindTransforms.set(i, bindTransform);
+		}
+		else {
+			skelData->restTransforms[i] = restTransform;
+			skelData->bindTransforms[i] = bindTransform;
+		}
+	}
+
+	if (compact) {
+		skelData->restTransforms.setLength(0);
+		skelData->bindTransforms.setLength(0);
+	}
+	else {
+		hashSubtrees(*skelData, TolerancePolicy::current(), skelData->subtrees);
+	}
+
+	MGlobal::displayInfo(MString("Parsed Maya skeleton with ") +
+		skelData->jointNames.length() + " joints");
+
+	return skelData;
+}
+
+MStatus ValidateRigCmd::parseMayaJointHierarchy(const MDagPath& root, MayaSkeletonData& skelData)
+{
+	MStatus status;
+
+	// Verify that root is a joint
+	if (!root.hasFn(MFn::kJoint)) {
+		MGlobal::displayError("Root path is not a joint");
+		return MS::kInvalidParameter;
+	}
 
-		// Add joint
-		int currentIndex = jointPaths.size();
-		jointPaths.push_back(dagPath);
-		jointNameToIndex[dagPath.partialPathName().asChar()] = currentIndex;
+	// Back to back calls find the hierarchy of an unchanged scene in the cache
+	SceneCache* sceneCache = SceneCache::instance();
+	if (sceneCache->findJointHierarchy(root, skelData)) {
+		skelData.restTransforms.setLength(skelData.jointPaths.length());
+		skelData.bindTransforms.setLength(skelData.jointPaths.length());
+		return MS::kSuccess;
+	}
 
-		// Traverse children
+	skelData.rootPath = root;
+
+	// Depth first, children in DAG order. Each joint is visited from its parent, so the
+	// parent index comes from the traversal instead of a lookup by name.
+	struct PendingJoint {
+		MDagPath path;
+		int parentIndex;
+	};
+	std::pmr::vector<PendingJoint> pending(RunArena::current());
+	pending.push_back({ root, -1 });
+
+	while (!pending.empty()) {
+		PendingJoint joint = pending.back();
+		pending.pop_back();
+
+		MFnDagNode dagNode(joint.path, &status);
+		if (status != MS::kSuccess) continue;
+
+		MFnIkJoint ikJoint(joint.path, &status);
+		if (status != MS::kSuccess) {
+			MGlobal::displayError("Failed to create MFnIkJoint for: " + joint.path.partialPathName());
+			return status;
+		}
+
+		int currentIndex = static_cast<int>(skelData.jointPaths.length());
+		skelData.jointPaths.append(joint.path);
+		skelData.jointNames.append(joint.path.partialPathName());
+		skelData.jointParentIndices.append(joint.parentIndex);
+
+		// Pushed in reverse so the first child is visited next
+		size_t firstChild = pending.size();
 		for (unsigned int i = 0; i < dagNode.childCount(); ++i) {
 			MObject child = dagNode.child(i, &status);
 			if (status == MS::kSuccess && child.hasFn(MFn::kJoint)) {
-				MDagPath childPath = dagPath;
+				MDagPath childPath = joint.path;
 				childPath.push(child);
-				traverseJoints(childPath);
+				pending.push_back({ childPath, currentIndex });
 			}
 		}
-	};
-
-	// Build joint hierarchy
-	traverseJoints(root);
+		std::reverse(pending.begin() + firstChild, pending.end());
+	}
 
-	if (jointPaths.empty()) {
+	if (skelData.jointPaths.length() == 0) {
 		MGlobal::displayError("No joints found in hierarchy");
-		return nullptr;
+		return MS::kFailure;
 	}
 
-	// Extract data for each joint
-	for (size_t i = 0; i < jointPaths.size(); ++i) {
-		const MDagPath& jointPath = jointPaths[i];
-		MFnIkJoint joint(jointPath, &status);
-		if (status != MS::kSuccess) {
-			MGlobal::displayError("Failed to create MFnIkJoint for: " + jointPath.partialPathName());
-			return nullptr;
-		}
-
-		// Joint name
-		skelData->jointNames.append(jointPath.partialPathName());
-
-		// Parent index
-		int parentIndex = -1;
-		if (jointPath.length() > 1) {
-			MDagPath parentPath = jointPath;
-			parentPath.pop();
-			if (parentPath.hasFn(MFn::kJoint)) {
-				auto it = jointNameToIndex.find(parentPath.partialPathName().asChar());
-				if (it != jointNameToIndex.end()) {
-					parentIndex = it->second;
-				}
-			}
-		}
-		skelData->jointParentIndices.append(parentIndex);
+	// Same form as USD joint tokens: the path of node names from the root joint down
+	unsigned int numJoints = skelData.jointPaths.length();
+	std::vector<std::string> jointPaths(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		std::string name = JointPathTable::stripNamespace(
+			MFnDagNode(skelData.jointPaths[i]).name().asChar());
+		int parent = skelData.jointParentIndices[i];
+		jointPaths[i] = parent >= 0 ? jointPaths[parent] + "/" + name : name;
+	}
+	skelData.jointIds.clear();
+	JointPathTable::instance().intern(jointPaths, skelData.jointIds);
 
-		// Rest transform
-		MMatrix jointWorldMatrix = jointPath.inclusiveMatrix(&status);
-		if (status != MS::kSuccess) {
-			MGlobal::displayError("Failed to get world matrix for: " + jointPath.partialPathName());
-			return nullptr;
-		}
-		MMatrix skelSpaceRestMatrix = jointWorldMatrix * rootWorldInverse;
-		skelData->restTransforms.append(skelSpaceRestMatrix);
+	sceneCache->storeJointHierarchy(root, skelData);
 
-		// Bind transform (inverse bind matrix from skin cluster)
-		MMatrix bindMatrix = getBindMatrixForJoint(jointPath, status);
-		if (status != MS::kSuccess) {
-			MGlobal::displayError("Failed to get bind matrix for: " + jointPath.partialPathName());
-			return nullptr;
-		}
-		skelData->bindTransforms.append(bindMatrix);
+	// Transforms are filled in per joint by parseMayaJoint
+	skelData.restTransforms.setLength(skelData.jointPaths.length());
+	skelData.bindTransforms.setLength(skelData.jointPaths.length());
+
+	return MS::kSuccess;
+}
+
+MStatus ValidateRigCmd::parseMayaJoint(const MDagPath& jointPath, const MMatrix& rootWorldInverse,
+	MMatrix& restTransform, MMatrix& bindTransform)
+{
+	MStatus status;
+
+	// Rest transform
+	MMatrix jointWorldMatrix = jointPath.inclusiveMatrix(&status);
+	if (status != MS::kSuccess) {
+		MGlobal::displayError("Failed to get world matrix for: " + jointPath.partialPathName());
+		return status;
 	}
+	restTransform = jointWorldMatrix * rootWorldInverse;
 
-	MGlobal::displayInfo(MString("Parsed Maya skeleton with ") +
-		skelData->jointNames.length() + " joints");
+	// Bind transform (inverse bind matrix from skin cluster)
+	bindTransform = getBindMatrixForJoint(jointPath, status);
+	if (status != MS::kSuccess) {
+		MGlobal::displayError("Failed to get bind matrix for: " + jointPath.partialPathName());
+		return status;
+	}
 
-	return skelData;
+	return MS::kSuccess;
 }
 
-std::unique_ptr<ValidateRigCmd::MayaSkinBindingData> ValidateRigCmd::parseMayaSkin(const MDagPath& meshPath)
+MObject ValidateRigCmd::findSkinCluster(const MDagPath& meshPath)
 {
-	MStatus status;
-	auto data = std::make_unique<MayaSkinBindingData>();
+	return SceneCache::instance()->skinClusters().skinClusterFor(meshPath);
+}
 
-	data->geomPath = meshPath;
+MStatus ValidateRigCmd::readGeomBindTransform(const MObject& skinClusterObj, MMatrix& geomBindTransform)
+{
+	MStatus status;
+	geomBindTransform = MMatrix::identity;
 
-	MObject meshObj = meshPath.node();
-	MItDependencyNodes itDep(MFn::kSkinClusterFilter);
+	// geomMatrix holds the deformed shape's world matrix at bind time, what USD authors as
+	// primvars:skel:geomBindTransform. bindPreMatrix[] belongs to the influences instead.
+	MFnDependencyNode skinCluster(skinClusterObj, &status);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+	MPlug geomMatrixPlug = skinCluster.findPlug("geomMatrix", true, &status);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
 
-	MObject skinClusterObj;
-	bool foundSkinCluster = false;
-
-	while (!itDep.isDone()) {
-		MObject currentObj = itDep.thisNode();
-		MFnSkinCluster skinCluster(currentObj, &status);
-
-		if (status == MS::kSuccess) {
-			// Check if this skin cluster is connected to our mesh
-			unsigned int numGeoms = skinCluster.numOutputConnections();
-			for (unsigned int i = 0; i < numGeoms; i++) {
-				unsigned int index = skinCluster.indexForOutputConnection(i, &status);
-				MDagPath outputPath;
-				skinCluster.getPathAtIndex(index, outputPath);
-
-				if (outputPath == meshPath) {
-					skinClusterObj = currentObj;
-					foundSkinCluster = true;
-					break;
-				}
-			}
-		}
+	MObject matrixData = geomMatrixPlug.asMObject(&status);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+	MFnMatrixData matrixFn(matrixData, &status);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+	geomBindTransform = matrixFn.matrix();
 
-		if (foundSkinCluster) break;
-		itDep.next();
-	}
+	return MS::kSuccess;
+}
 
-	if (!foundSkinCluster) {
+std::unique_ptr<ValidateRigCmd::MayaSkinBindingData> ValidateRigCmd::parseMayaSkin(const MDagPath& meshPath, InfluenceIndex* influences)
+{
+	MObject skinClusterObj = findSkinCluster(meshPath);
+	if (skinClusterObj.isNull()) {
 		MGlobal::displayWarning("No skin cluster found for mesh: " + meshPath.fullPathName());
 		return nullptr;
 	}
 
+	return parseMayaSkin(meshPath, skinClusterObj, influences);
+}
+
+std::unique_ptr<ValidateRigCmd::MayaSkinBindingData> ValidateRigCmd::parseMayaSkin(const MDagPath& meshPath, const MObject& skinClusterObj,
+	InfluenceIndex* influences)
+{
+	MStatus status;
+	auto data = std::make_unique<MayaSkinBindingData>();
+
+	data->geomPath = meshPath;
+	data->skinClusterNode = skinClusterObj;
+
 	MFnSkinCluster skinCluster(skinClusterObj, &status);
 	CHECK_MSTATUS_AND_RETURN(status, nullptr);
 
@@ -337,68 +1454,86 @@ std::unique_ptr<ValidateRigCmd::MayaSkinBindingData> ValidateRigCmd::parseMayaSk
 		return nullptr;
 	}
 
-	// Common root for all influences
-	data->skelPath = influencePaths[0];
-	while (data->skelPath.length() > 0) {
-		bool isCommonRoot = true;
-		MString rootPathStr = data->skelPath.fullPathName();
-
-		for (unsigned int i = 1; i < numInfluences; i++) {
-			MString influencePathStr = influencePaths[i].fullPathName();
-			// Check if influence path starts with root path
-			if (influencePathStr.indexW(rootPathStr) != 0) {
-				isCommonRoot = false;
-				break;
-			}
-		}
-		if (isCommonRoot) break;
-		data->skelPath.pop();
-	}
-
-	// Geo bind transorm
-	MFnTransform geomTransform(meshPath, &status);
-	if (status == MS::kSuccess) {
-		// Get the world matrix at bind time
-		MPlug bindPreMatrixPlug = skinCluster.findPlug("bindPreMatrix", true, &status);
-		if (status == MS::kSuccess && bindPreMatrixPlug.isArray()) {
-			MPlug elementPlug = bindPreMatrixPlug.elementByLogicalIndex(0, &status);
-			if (status == MS::kSuccess) {
-				MObject matrixData;
-				elementPlug.getValue(matrixData);
-				MFnMatrixData matrixFn(matrixData);
-				data->geomBindTransform = matrixFn.matrix();
+	// Common root for all influences. Resolved from the skeleton's parent indices once per
+	// skin cluster when every influence is one of its joints, shared by the cluster's meshes.
+	int commonRoot = influences ? influences->influences(skinClusterObj).commonRoot : -1;
+	if (commonRoot >= 0) {
+		data->skelPath = influences->skeleton().jointPaths[commonRoot];
+	}
+	else {
+		// Influences outside the skeleton, fall back to comparing path prefixes
+		data->skelPath = influencePaths[0];
+		while (data->skelPath.length() > 0) {
+			bool isCommonRoot = true;
+			MString rootPathStr = data->skelPath.fullPathName();
+
+			for (unsigned int i = 1; i < numInfluences; i++) {
+				MString influencePathStr = influencePaths[i].fullPathName();
+				// Check if influence path starts with root path
+				if (influencePathStr.indexW(rootPathStr) != 0) {
+					isCommonRoot = false;
+					break;
+				}
 			}
+			if (isCommonRoot) break;
+			data->skelPath.pop();
 		}
 	}
 
+	// Geometry bind transform, read once per skin cluster when they are indexed
+	if (influences) {
+		data->geomBindTransform = influences->influences(skinClusterObj).geomBindTransform;
+	}
+	else {
+		readGeomBindTransform(skinClusterObj, data->geomBindTransform);
+	}
+
 	// Get vertex weights and joint indices
 	MItGeometry geoIter(meshPath);
 	unsigned int vertexCount = geoIter.count();
 
+	// Influence slots to skeleton joints, resolved once per skin cluster, so both sides
+	// of the comparison hold skeleton joint indices
+	const std::vector<int>* slotJoints = nullptr;
+	if (influences) {
+		slotJoints = &influences->influences(skinClusterObj).slotJoints;
+	}
+
+	if (readSparseSkinWeights(skinCluster, influencePaths, slotJoints, vertexCount, *data)) {
+		return data;
+	}
+
 	// Preallocate arrays, estimate 4 influences per vertex
 	data->jointIndices.setLength(vertexCount * 4);
 	data->jointWeights.setLength(vertexCount * 4);
+	data->vertexOffsets.setLength(vertexCount + 1);
 
 	unsigned int arrayIndex = 0;
+	unsigned int vertexIndex = 0;
+
+	// Reused across vertices, getWeights resizes it in place
+	MDoubleArray weights;
+	unsigned int influenceCount;
 
 	for (; !geoIter.isDone(); geoIter.next()) {
+		data->vertexOffsets[vertexIndex++] = arrayIndex;
+
 		MObject component = geoIter.currentItem();
 
 		// Get weights for this vertex
-		MDoubleArray weights;
-		unsigned int influenceCount;
 		skinCluster.getWeights(meshPath, component, weights, influenceCount);
 
 		// Store non-zero weights
 		for (unsigned int i = 0; i < influenceCount; i++) {
-			if (weights[i] > 0.0001) {  // Threshold to skip negligible weights
+			if (weights[i] > kWeightPruneThreshold) {  // Threshold to skip negligible weights
 				// Make sure we have space
 				if (arrayIndex >= data->jointIndices.length()) {
 					data->jointIndices.setLength(data->jointIndices.length() + vertexCount);
 					data->jointWeights.setLength(data->jointWeights.length() + vertexCount);
 				}
 
-				data->jointIndices[arrayIndex] = i;
+				data->jointIndices[arrayIndex] = !slotJoints ? static_cast<int>(i) :
+					i < slotJoints->size() ? (*slotJoints)[i] : -1;
 				data->jointWeights[arrayIndex] = static_cast<float>(weights[i]);
 				arrayIndex++;
 			}
@@ -408,22 +1543,69 @@ std::unique_ptr<ValidateRigCmd::MayaSkinBindingData> ValidateRigCmd::parseMayaSk
 	// Trim arrays to actual size
 	data->jointIndices.setLength(arrayIndex);
 	data->jointWeights.setLength(arrayIndex);
+	data->vertexOffsets.setLength(vertexIndex + 1);
+	data->vertexOffsets[vertexIndex] = arrayIndex;
 
 	return data;
 }
 
+MDagPathArray ValidateRigCmd::findSkinnedMeshes(const MDagPath& root)
+{
+	return SceneCache::instance()->skinClusters().skinnedMeshes(root);
+}
+
+MString ValidateRigCmd::geomName(const MDagPath& meshPath)
+{
+	// USD mesh prims come in as a transform with a shape below it, the transform carries the prim name
+	MFnDagNode transformNode(meshPath.transform());
+	return transformNode.name();
+}
+
+std::unique_ptr<ValidateRigCmd::MayaRigData> ValidateRigCmd::parseMayaRig(const MDagPath& root, bool compact)
+{
+	return parseMayaRig(root, SceneCache::instance()->skinClusters(), compact);
+}
+
+std::unique_ptr<ValidateRigCmd::MayaRigData> ValidateRigCmd::parseMayaRig(const MDagPath& root,
+	const SkinClusterIndex& skinClusters, bool compact)
+{
+	auto rigData = std::make_unique<MayaRigData>();
+
+	auto skelData = parseMayaSkel(root, compact);
+	if (!skelData) return nullptr;
+	rigData->skeleton = std::move(*skelData);
+
+	// Meshes deformed by the same skin cluster share its resolved influences
+	InfluenceIndex influences(rigData->skeleton);
+
+	MDagPathArray meshPaths = skinClusters.skinnedMeshes(root);
+	for (unsigned int i = 0; i < meshPaths.length(); ++i) {
+		auto skinData = parseMayaSkin(meshPaths[i], skinClusters.skinClusterFor(meshPaths[i]), &influences);
+		if (!skinData) continue;
+
+		rigData->skinBindings.push_back(std::move(*skinData));
+		rigData->geomNames.append(geomName(meshPaths[i]));
+	}
+
+	return rigData;
+}
+
 bool ValidateRigCmd::quickValidateSkeleton(const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel) 
 {
 	// Fastest checks
 	if (usdSkel.jointNames.size() != mayaSkel.jointNames.length()) return false;
 	if (usdSkel.jointParentIndices.size() != mayaSkel.jointParentIndices.length()) return false;
-	if (usdSkel.bindTransforms.size() != mayaSkel.bindTransforms.length()) return false;
+	size_t mayaTransformCount = mayaSkel.compact ?
+		mayaSkel.compactBindTransforms.size() : mayaSkel.bindTransforms.length();
+	if (usdSkel.bindTransforms.size() != mayaTransformCount) return false;
+
+	// Only subtrees whose hashes differ can hold a mismatch
+	std::pmr::vector<int> joints(RunArena::current());
+	jointsToCompare(usdSkel, mayaSkel, joints);
+	if (joints.empty()) return true;
 
 	// Slower checks
-	for (size_t i = 0; i < usdSkel.jointNames.size(); ++i) {
-		if (usdSkel.jointNames[i] != mayaSkel.jointNames[i].asChar())
-			return false;
-	}
+	if (usdSkel.jointIds != mayaSkel.jointIds) return false;
 
 	for (size_t i = 0; i < usdSkel.jointParentIndices.size(); ++i) {
 		if (usdSkel.jointParentIndices[i] != mayaSkel.jointParentIndices[i])
@@ -431,275 +1613,839 @@ bool ValidateRigCmd::quickValidateSkeleton(const USDSkeletonData& usdSkel, const
 	}
 
 	// Slowest checks
-	for (size_t i = 0; i < usdSkel.bindTransforms.size(); ++i) {
-		if (!matricesMatch(usdSkel.bindTransforms[i], mayaSkel.bindTransforms[i]))
-			return false;
+	if (mayaSkel.compact) {
+		std::vector<unsigned char> flagged;
+		const TolerancePolicy& policy = TolerancePolicy::current();
+		screenCompactTransforms(usdSkel.bindTransforms, mayaSkel.compactBindTransforms, policy, flagged);
+		for (size_t i = 0; i < flagged.size(); ++i) {
+			if (flagged[i] && !jointTransformMatches(usdSkel.bindTransforms[i], mayaSkel, i, true))
+				return false;
+		}
+
+		screenCompactTransforms(usdSkel.restTransforms, mayaSkel.compactRestTransforms, policy, flagged);
+		for (size_t i = 0; i < flagged.size(); ++i) {
+			if (flagged[i] && !jointTransformMatches(usdSkel.restTransforms[i], mayaSkel, i, false))
+				return false;
+		}
+
+		return true;
 	}
 
-	for (size_t i = 0; i < usdSkel.restTransforms.size(); ++i) {
-		if (!matricesMatch(usdSkel.restTransforms[i], mayaSkel.restTransforms[i]))
-			return false;
+	if (usdSkel.restTransforms.size() != mayaSkel.restTransforms.length()) return false;
+
+	std::pmr::vector<TransformDecomposition::Errors> errors(RunArena::current());
+	compareJointTransforms(usdSkel.bindTransforms, mayaSkel.bindTransforms, joints, errors);
+	for (const TransformDecomposition::Errors& e : errors) {
+		if (!e.matches) return false;
+	}
+
+	compareJointTransforms(usdSkel.restTransforms, mayaSkel.restTransforms, joints, errors);
+	for (const TransformDecomposition::Errors& e : errors) {
+		if (!e.matches) return false;
 	}
 
 	return true;
 }
 
-std::vector<ValidateRigCmd::ValidationIssue> ValidateRigCmd::detailedValidateSkeleton(
-	const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel
+void ValidateRigCmd::detailedValidateSkeleton(
+	const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel, IssueSink& issues
 )
 {
-	std::vector<ValidationIssue> issues;
-
 	// Joint count
 	if (usdSkel.jointNames.size() != mayaSkel.jointNames.length()) {
-		MString desc;
-		desc.format("Joint count mismatch: USD has ^1s joints, Maya has ^2s joints",
-			MString() + (int)usdSkel.jointNames.size(),
-			MString() + mayaSkel.jointNames.length());
-		issues.emplace_back(ValidationIssue::Type::JOINT_COUNT_MISMATCH, desc);
-		
-		return issues; // For loops later won't work with number mismatch, return early 
+		issues.add(ValidationIssue(ValidationIssue::Type::JOINT_COUNT_MISMATCH, -1,
+			(double)usdSkel.jointNames.size(), (double)mayaSkel.jointNames.length()));
+		return; // For loops later won't work with number mismatch, return early 
 	}
 
-	// Joint names
-	for (size_t i = 0; i < usdSkel.jointNames.size(); ++i) {
-		if (usdSkel.jointNames[i] != mayaSkel.jointNames[i].asChar()) {
-			MString desc;
-			desc.format("Joint ^1s name mismatch: USD=''^2s'', Maya=''^3s''",
-				MString() + (int)i,
-				MString(usdSkel.jointNames[i].GetString().c_str()),
-				mayaSkel.jointNames[i]);
-			issues.emplace_back(ValidationIssue::Type::JOINT_NAME_MISMATCH, desc, i);
+	// Joints that no longer line up by name may have been renamed or reordered. Bucketing
+	// the USD bind transforms lets each of them look up the USD joint it most likely is.
+	MatrixBuckets usdBindBuckets;
+	bool bucketed = !mayaSkel.compact && usdSkel.jointIds != mayaSkel.jointIds;
+	if (bucketed) {
+		const TolerancePolicy& policy = TolerancePolicy::current();
+		usdBindBuckets.reserve(usdSkel.bindTransforms.size());
+		for (size_t i = 0; i < usdSkel.bindTransforms.size(); ++i) {
+			usdBindBuckets.emplace(policy.quantizedHash(usdSkel.bindTransforms[i]), static_cast<int>(i));
 		}
 	}
 
-	// Parent indices
-	for (size_t i = 0; i < usdSkel.jointParentIndices.size(); ++i) {
-		if (usdSkel.jointParentIndices[i] != mayaSkel.jointParentIndices[i]) {
-			MString desc;
-			desc.format("Joint ^1s parent index mismatch: USD=^2s, Maya^3s",
-				MString() + (int)i,
-				MString() + usdSkel.jointParentIndices[i],
-				MString() + mayaSkel.jointParentIndices[i]);
-			issues.emplace_back(ValidationIssue::Type::PARENT_INDEX_MISMATCH, desc, i);
+	// Subtrees whose hashes agree are skipped whole. Full precision transforms of the joints
+	// left are decomposed at once, compact ones are screened and re-read joint by joint.
+	std::pmr::vector<int> joints(RunArena::current());
+	jointsToCompare(usdSkel, mayaSkel, joints);
+
+	std::pmr::vector<TransformDecomposition::Errors> bindErrors(RunArena::current());
+	std::pmr::vector<TransformDecomposition::Errors> restErrors(RunArena::current());
+	if (!mayaSkel.compact) {
+		compareJointTransforms(usdSkel.bindTransforms, mayaSkel.bindTransforms, joints, bindErrors);
+		compareJointTransforms(usdSkel.restTransforms, mayaSkel.restTransforms, joints, restErrors);
+	}
+
+	for (size_t k = 0; k < joints.size(); ++k) {
+		detailedValidateJoint(usdSkel, mayaSkel, joints[k], issues, bucketed ? &usdBindBuckets : nullptr,
+			k < bindErrors.size() ? &bindErrors[k] : nullptr,
+			k < restErrors.size() ? &restErrors[k] : nullptr);
+	}
+}
+
+void ValidateRigCmd::jointsToCompare(const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel,
+	std::pmr::vector<int>& joints)
+{
+	int numJoints = static_cast<int>(mayaSkel.jointIds.size());
+	joints.clear();
+
+	// Hashes parsed under another policy are built again here, compact transforms have none
+	const TolerancePolicy& policy = TolerancePolicy::current();
+	uint64_t policyKey = policy.key();
+	SubtreeHashes usdScratch, mayaScratch;
+	const SubtreeHashes* usdHashes = &usdSkel.subtrees;
+	const SubtreeHashes* mayaHashes = &mayaSkel.subtrees;
+	if (!mayaSkel.compact) {
+		if (!usdHashes->builtFor(policyKey)) {
+			hashSubtrees(usdSkel, policy, usdScratch);
+			usdHashes = &usdScratch;
+		}
+		if (!mayaHashes->builtFor(policyKey)) {
+			hashSubtrees(mayaSkel, policy, mayaScratch);
+			mayaHashes = &mayaScratch;
 		}
 	}
 
-	// Bind Transforms
-	for (size_t i = 0; i < usdSkel.bindTransforms.size(); ++i) {
-		if (!matricesMatch(usdSkel.bindTransforms[i], mayaSkel.bindTransforms[i])) {
-			MString desc;
-			desc.format("Joint ^1s (^2s) bind transform mismatch",
-				MString() + (int)i,
-				mayaSkel.jointNames[i]);
-			issues.emplace_back(ValidationIssue::Type::BIND_TRANSFORM_MISMATCH, desc, i);
+	if (mayaSkel.compact || !usdHashes->builtFor(policyKey) || !mayaHashes->builtFor(policyKey) ||
+		usdHashes->size() != static_cast<size_t>(numJoints) || mayaHashes->size() != static_cast<size_t>(numJoints)) {
+		joints.resize(numJoints);
+		for (int i = 0; i < numJoints; ++i) {
+			joints[i] = i;
 		}
+		return;
 	}
-	
-	// Rest transforms
-	for (size_t i = 0; i < usdSkel.restTransforms.size(); ++i) {
-		if (!matricesMatch(usdSkel.restTransforms[i], mayaSkel.restTransforms[i])) {
-			MString desc;
-			desc.format("Joint ^1s (^2s) rest transform mismatch",
-				MString() + (int)i,
-				mayaSkel.jointNames[i]);
-			issues.emplace_back(ValidationIssue::Type::REST_TRANSFORM_MISMATCH, desc, i);
+
+	// Maya joints are in depth first order, so each skipped subtree is a range of indices
+	for (int i = 0; i < numJoints;) {
+		if ((*usdHashes)[i] == (*mayaHashes)[i]) {
+			i = mayaHashes->subtreeEnd(i);
+			continue;
+		}
+		joints.push_back(i);
+		++i;
+	}
+}
+
+void ValidateRigCmd::hashSubtrees(const USDSkeletonData& skel, const TolerancePolicy& policy, SubtreeHashes& subtrees)
+{
+	size_t numJoints = skel.jointIds.size();
+	if (skel.jointParentIndices.size() != numJoints || skel.bindTransforms.size() != numJoints ||
+		skel.restTransforms.size() != numJoints) {
+		subtrees.clear();
+		return;
+	}
+
+	std::vector<int> parents(skel.jointParentIndices.begin(), skel.jointParentIndices.end());
+	std::vector<uint64_t> leaves(numJoints);
+	for (size_t i = 0; i < numJoints; ++i) {
+		leaves[i] = jointLeafHash(i, skel.jointIds[i], parents[i],
+			skel.bindTransforms[i].GetArray(), skel.restTransforms[i].GetArray(), policy);
+	}
+	subtrees.build(leaves, parents, policy.key());
+}
+
+void ValidateRigCmd::hashSubtrees(const MayaSkeletonData& skel, const TolerancePolicy& policy, SubtreeHashes& subtrees)
+{
+	unsigned int numJoints = static_cast<unsigned int>(skel.jointIds.size());
+	if (skel.compact || skel.jointParentIndices.length() != numJoints ||
+		skel.bindTransforms.length() != numJoints || skel.restTransforms.length() != numJoints) {
+		subtrees.clear();
+		return;
+	}
+
+	std::vector<int> parents(numJoints);
+	std::vector<uint64_t> leaves(numJoints);
+	for (unsigned int i = 0; i < numJoints; ++i) {
+		parents[i] = skel.jointParentIndices[i];
+		leaves[i] = jointLeafHash(i, skel.jointIds[i], parents[i],
+			&skel.bindTransforms[i].matrix[0][0], &skel.restTransforms[i].matrix[0][0], policy);
+	}
+	subtrees.build(leaves, parents, policy.key());
+}
+
+void ValidateRigCmd::detailedValidateJoint(
+	const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel,
+	size_t i, IssueSink& issues, const MatrixBuckets* usdBindBuckets,
+	const TransformDecomposition::Errors* bindErrors, const TransformDecomposition::Errors* restErrors
+)
+{
+	// Joint name, actual is the USD joint with the Maya joint's bind transform or -1
+	if (usdSkel.jointIds[i] != mayaSkel.jointIds[i]) {
+		int sameBind = -1;
+		if (usdBindBuckets && i < mayaSkel.bindTransforms.length()) {
+			sameBind = findBindTransform(usdSkel.bindTransforms, *usdBindBuckets, mayaSkel.bindTransforms[i]);
 		}
+		issues.add(ValidationIssue(ValidationIssue::Type::JOINT_NAME_MISMATCH, (int)i, 0.0, (double)sameBind));
+	}
+
+	// Parent index
+	if (usdSkel.jointParentIndices[i] != mayaSkel.jointParentIndices[i]) {
+		issues.add(ValidationIssue(ValidationIssue::Type::PARENT_INDEX_MISMATCH, (int)i,
+			usdSkel.jointParentIndices[i], mayaSkel.jointParentIndices[i]));
+	}
+
+	// Bind transform, batched errors are used when the caller has them
+	TransformDecomposition::Errors errors;
+	if (bindErrors) {
+		errors = *bindErrors;
+	}
+	else {
+		jointTransformMatches(usdSkel.bindTransforms[i], mayaSkel, i, true, &errors);
+	}
+	if (!errors.matches) {
+		issues.add(ValidationIssue::makeTransformMismatch(ValidationIssue::Type::BIND_TRANSFORM_MISMATCH, (int)i, errors));
 	}
 
-	return issues;
+	// Rest transform
+	errors = TransformDecomposition::Errors();
+	if (restErrors) {
+		errors = *restErrors;
+	}
+	else {
+		jointTransformMatches(usdSkel.restTransforms[i], mayaSkel, i, false, &errors);
+	}
+	if (!errors.matches) {
+		issues.add(ValidationIssue::makeTransformMismatch(ValidationIssue::Type::REST_TRANSFORM_MISMATCH, (int)i, errors));
+	}
 }
 
 bool ValidateRigCmd::quickValidateSkinBinding(
 	const USDSkinBindingData& usdSkin,
 	const MayaSkinBindingData& mayaSkin) 
 {
-	// Quick checks
-	if (usdSkin.jointIndices.size() != mayaSkin.jointIndices.length()) return false;
+	// Quick checks, the geometry bind transform is left to validateGeomBindTransforms
+	long long vertexCount = skinVertexCount(usdSkin, mayaSkin);
+	if (vertexCount < 0) return false;
+
+	// Per-vertex influences, stop all chunks as soon as one vertex differs
+	std::atomic<bool> mismatch(false);
+	WorkParallelForN(static_cast<size_t>(vertexCount), [&](size_t begin, size_t end) {
+		SkinRow usdRow, mayaRow;
+		float maxDiff;
+		for (size_t v = begin; v < end && !mismatch.load(std::memory_order_relaxed); ++v) {
+			readUSDSkinRow(usdSkin, v, usdRow);
+			readMayaSkinRow(mayaSkin, static_cast<unsigned int>(v), mayaRow);
+			if (compareSkinRows(usdRow, mayaRow, maxDiff) != SkinVertexResult::MATCH) {
+				mismatch = true;
+			}
+		}
+	});
 
-	if (usdSkin.jointWeights.size() != mayaSkin.jointWeights.length()) return false;
+	return !mismatch;
+}
 
-	// Joint indices
-	for (size_t i = 0; i < usdSkin.jointIndices.size(); ++i) {
-		if (usdSkin.jointIndices[i] != mayaSkin.jointIndices[i]) return false;
+void ValidateRigCmd::detailedValidateSkinBinding(
+	const USDSkinBindingData& usdSkin,
+	const MayaSkinBindingData& mayaSkin,
+	int geomIndex,
+	IssueSink& issues
+)
+{
+	// USD rows must be fully populated
+	if (usdSkin.elementSize <= 0 || usdSkin.jointIndices.size() != usdSkin.jointWeights.size()) {
+		issues.add(ValidationIssue(ValidationIssue::Type::INVALID_SKIN_BINDING, -1,
+			(double)usdSkin.jointIndices.size(), (double)usdSkin.jointWeights.size(),
+			0.0, geomIndex));
+		return;
 	}
 
-	// Joint weights
-	const float weightTolerance = 1e-5f;
-	for (size_t i = 0; i < usdSkin.jointWeights.size(); ++i) {
-		float diff = std::abs(usdSkin.jointWeights[i] - mayaSkin.jointWeights[i]);
-		if (diff > weightTolerance) {
-			return false;
+	// Vertex count
+	long long vertexCount = skinVertexCount(usdSkin, mayaSkin);
+	if (vertexCount < 0) {
+		issues.add(ValidationIssue(ValidationIssue::Type::WEIGHT_COUNT_MISMATCH, -1,
+			(double)(usdSkin.jointIndices.size() / usdSkin.elementSize),
+			(double)(mayaSkin.vertexOffsets.length() > 0 ? mayaSkin.vertexOffsets.length() - 1 : 0),
+			0.0, geomIndex));
+		return; // For loops later won't work with number mismatch, return early 
+	}
+
+	// Split the vertices into fixed ranges so the chunk boundaries, and with them the
+	// merged report, do not depend on how many threads pick up the work
+	size_t numChunks = (static_cast<size_t>(vertexCount) + kSkinChunkSize - 1) / kSkinChunkSize;
+	std::pmr::vector<BoundedIssueSink> chunks(numChunks, BoundedIssueSink(issues.sampleLimit()),
+		RunArena::current());
+	WorkParallelForN(numChunks, [&](size_t chunkBegin, size_t chunkEnd) {
+		SkinRow usdRow, mayaRow;
+		float maxDiff;
+		for (size_t c = chunkBegin; c < chunkEnd; ++c) {
+			BoundedIssueSink& chunk = chunks[c];
+			size_t end = std::min((c + 1) * kSkinChunkSize, static_cast<size_t>(vertexCount));
+			for (size_t v = c * kSkinChunkSize; v < end; ++v) {
+				readUSDSkinRow(usdSkin, v, usdRow);
+				readMayaSkinRow(mayaSkin, static_cast<unsigned int>(v), mayaRow);
+				SkinVertexResult result = compareSkinRows(usdRow, mayaRow, maxDiff);
+				if (result == SkinVertexResult::INFLUENCE_MISMATCH) {
+					chunk.add(ValidationIssue(ValidationIssue::Type::JOINT_INDEX_MISMATCH, (int)v,
+						0.0, 0.0, 0.0, geomIndex));
+				}
+				else if (result == SkinVertexResult::WEIGHT_MISMATCH) {
+					chunk.add(ValidationIssue(ValidationIssue::Type::WEIGHT_VALUE_MISMATCH, (int)v,
+						0.0, 0.0, maxDiff, geomIndex));
+				}
+			}
 		}
+	});
+
+	// Merge in chunk order, each chunk already holds its own first samples in vertex order
+	BoundedIssueSink vertexIssues(issues.sampleLimit());
+	for (const BoundedIssueSink& chunk : chunks) {
+		vertexIssues.merge(chunk);
 	}
+	issues.merge(vertexIssues);
+}
 
-	// Geometry bind transform
-	if (!matricesMatch(usdSkin.geomBindTransform, mayaSkin.geomBindTransform)) return false;
+void ValidateRigCmd::validateRig(const USDRigData& usdRig, const MayaRigData& mayaRig, IssueSink& issues)
+{
+	if (!quickValidateSkeleton(usdRig.skeleton, mayaRig.skeleton)) {
+		detailedValidateSkeleton(usdRig.skeleton, mayaRig.skeleton, issues);
+	}
 
-	return true;
+	validateGeomBindTransforms(usdRig, mayaRig, 0, mayaRig.skinBindings.size(), issues);
+	for (size_t i = 0; i < mayaRig.skinBindings.size(); ++i) {
+		validateSkin(usdRig, mayaRig, i, issues, false);
+	}
 }
 
-std::vector<ValidateRigCmd::ValidationIssue> ValidateRigCmd::detailedValidateSkinBinding(
-	const USDSkinBindingData& usdSkin,
-	const MayaSkinBindingData& mayaSkin
-)
+void ValidateRigCmd::validateGeomBindTransforms(const USDRigData& usdRig, const MayaRigData& mayaRig,
+	size_t skinBegin, size_t skinEnd, IssueSink& issues)
 {
-	std::vector<ValidationIssue> issues;
-
-	// Joint indices count
-	if (usdSkin.jointIndices.size() != mayaSkin.jointIndices.length()) {
-		MString desc;
-		desc.format("Joint indices count mismatch: USD has ^1s, Maya has ^2s",
-			MString() + (int)usdSkin.jointIndices.size(),
-			MString() + mayaSkin.jointIndices.length());
-		issues.emplace_back(ValidationIssue::Type::WEIGHT_COUNT_MISMATCH, desc);
-		return issues; // For loops later won't work with number mismatch, return early 
-	}
-
-	// Joint weight count
-	if (usdSkin.jointWeights.size() != mayaSkin.jointWeights.length()) {
-		MString desc;
-		desc.format("Joint weights count mismatch: USD has ^1s, Maya has ^2s",
-			MString() + (int)usdSkin.jointWeights.size(),
-			MString() + mayaSkin.jointWeights.length());
-		issues.emplace_back(ValidationIssue::Type::WEIGHT_COUNT_MISMATCH, desc);
-		return issues; // For loops later won't work with number mismatch, return early 
-	}
-
-	// Compare joint indices
-	int indicesMismatchCount = 0;
-	for (size_t i = 0; i < usdSkin.jointIndices.size(); ++i) {
-		if (usdSkin.jointIndices[i] != mayaSkin.jointIndices[i]) {
-			indicesMismatchCount++;
-			// Only report first 5 mismatches
-			if (indicesMismatchCount <= 5) {
-				MString desc;
-				desc.format("Joint index mismatch at position ^1s: USD=^2s, Maya=^3s",
-					MString() + (int)i,
-					MString() + usdSkin.jointIndices[i],
-					MString() + mayaSkin.jointIndices[i]);
-				issues.emplace_back(ValidationIssue::Type::JOINT_INDEX_MISMATCH, desc, i);
+	// Every pair is packed first and compared in one pass, meshes without a USD binding
+	// are left to validateSkin
+	std::pmr::vector<int> skinIndices(RunArena::current());
+	std::pmr::vector<double> usdMats(RunArena::current());
+	std::pmr::vector<double> mayaMats(RunArena::current());
+	skinIndices.reserve(skinEnd - skinBegin);
+	usdMats.reserve((skinEnd - skinBegin) * 16);
+	mayaMats.reserve((skinEnd - skinBegin) * 16);
+	for (size_t i = skinBegin; i < skinEnd; ++i) {
+		int usdIndex = findSkinBinding(usdRig, mayaRig.geomNames[i]);
+		if (usdIndex < 0) continue;
+
+		const GfMatrix4d& usdMat = usdRig.skinBindings[usdIndex].geomBindTransform;
+		const MMatrix& mayaMat = mayaRig.skinBindings[i].geomBindTransform;
+		skinIndices.push_back(static_cast<int>(i));
+		for (int row = 0; row < 4; ++row) {
+			for (int col = 0; col < 4; ++col) {
+				usdMats.push_back(usdMat[row][col]);
+				mayaMats.push_back(mayaMat(row, col));
 			}
 		}
 	}
-	if (indicesMismatchCount > 5) {
-		MString desc;
-		desc.format("... and ^1s more joint index mismatches (showing first 5 only)",
-			MString() + (indicesMismatchCount - 5));
-		issues.emplace_back(ValidationIssue::Type::JOINT_INDEX_MISMATCH, desc);
-	}
-
-	// Compare joint weights
-	const float weightTolerance = 1e-5f;
-	int weightsMismatchCount = 0;
-	for (size_t i = 0; i < usdSkin.jointWeights.size(); ++i) {
-		float diff = std::abs(usdSkin.jointWeights[i] - mayaSkin.jointWeights[i]);
-		if (diff > weightTolerance) {
-			weightsMismatchCount++;
-			// Only report first 5 mismatches to avoid spam
-			if (weightsMismatchCount <= 5) {
-				MString desc;
-				desc.format("Weight mismatch at position ^1s: USD=^2s, Maya=^3s (diff=^4s)",
-					MString() + (int)i,
-					MString() + usdSkin.jointWeights[i],
-					MString() + mayaSkin.jointWeights[i],
-					MString() + diff);
-				issues.emplace_back(ValidationIssue::Type::WEIGHT_VALUE_MISMATCH, desc, i);
-			}
+
+	std::pmr::vector<TransformDecomposition::Errors> errors(skinIndices.size(), RunArena::current());
+	TransformDecomposition::compare(usdMats.data(), mayaMats.data(), skinIndices.size(),
+		TolerancePolicy::current(), errors.data());
+	for (size_t m = 0; m < skinIndices.size(); ++m) {
+		if (!errors[m].matches) {
+			issues.add(ValidationIssue::makeTransformMismatch(ValidationIssue::Type::GEOM_BIND_TRANSFORM_MISMATCH, -1,
+				errors[m], skinIndices[m]));
 		}
 	}
-	if (weightsMismatchCount > 5) {
-		MString desc;
-		desc.format("... and ^1s more weight mismatches (showing first 5 only)",
-			MString() + (weightsMismatchCount - 5));
-		issues.emplace_back(ValidationIssue::Type::WEIGHT_VALUE_MISMATCH, desc);
+}
+
+void ValidateRigCmd::validateSkin(const USDRigData& usdRig, const MayaRigData& mayaRig,
+	size_t skinIndex, IssueSink& issues, bool checkGeomBind)
+{
+	int usdIndex = findSkinBinding(usdRig, mayaRig.geomNames[skinIndex]);
+	if (usdIndex < 0) {
+		issues.add(ValidationIssue(ValidationIssue::Type::SKIN_BINDING_MISSING, -1,
+			0.0, 0.0, 0.0, (int)skinIndex));
+		return;
+	}
+
+	// validateRig checks every mesh's geometry bind transform up front
+	if (checkGeomBind) {
+		validateGeomBindTransforms(usdRig, mayaRig, skinIndex, skinIndex + 1, issues);
 	}
 
-	// Geometry bind transform
-	if (!matricesMatch(usdSkin.geomBindTransform, mayaSkin.geomBindTransform)) {
-		MString desc("Geometry bind transform mismatch");
-		issues.emplace_back(ValidationIssue::Type::GEOM_BIND_TRANSFORM_MISMATCH, desc);
+	// Streamed weights live until the end of this comparison
+	USDSkinBindingData streamed;
+	const USDSkinBindingData* usdSkin = &usdRig.skinBindings[usdIndex];
+	if (usdSkin->weightsDeferred) {
+		streamed = *usdSkin;
+		if (!usdRig.stage || !readUSDSkinWeights(usdRig.stage->GetPrimAtPath(streamed.geomPath), streamed)) {
+			ValidationLog::warning("Failed to read skinning primvars: " + MString(streamed.geomPath.GetText()));
+			issues.add(ValidationIssue(ValidationIssue::Type::SKIN_BINDING_MISSING, -1,
+				0.0, 0.0, 0.0, (int)skinIndex));
+			return;
+		}
+		usdSkin = &streamed;
 	}
 
-	return issues;
+	const MayaSkinBindingData& mayaSkin = mayaRig.skinBindings[skinIndex];
+	if (quickValidateSkinBinding(*usdSkin, mayaSkin)) return;
+
+	detailedValidateSkinBinding(*usdSkin, mayaSkin, (int)skinIndex, issues);
 }
 
-bool ValidateRigCmd::matricesMatch(const GfMatrix4d& usdMat,
-	const MMatrix& mayaMat,
-	double tolerance)
+void ValidateRigCmd::validateAnimation(const MString& filePath,
+	const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel,
+	double startFrame, double endFrame, double frameStep, IssueSink& issues)
 {
-	for (int row = 0; row < 4; ++row) {
-		for (int col = 0; col < 4; ++col) {
-			double diff = std::abs(usdMat[row][col] - mayaMat(row, col));
-			if (diff > tolerance)
-				return false;
+	if (usdSkel.jointNames.size() != mayaSkel.jointPaths.length()) return; // Already reported by the static checks
+
+	UsdStageRefPtr stage = openUSDStage(filePath);
+	if (!stage) return;
+	validateAnimation(stage, usdSkel, mayaSkel, startFrame, endFrame, frameStep, issues);
+}
+
+void ValidateRigCmd::validateAnimation(const UsdStageRefPtr& stage,
+	const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel,
+	double startFrame, double endFrame, double frameStep, IssueSink& issues)
+{
+	size_t numJoints = usdSkel.jointNames.size();
+	if (numJoints != mayaSkel.jointPaths.length()) return; // Already reported by the static checks
+
+	// UsdSkelCache only resolves skeletons below a SkelRoot, the skeleton query wraps the
+	// animation's UsdSkelAnimQuery and remaps its joints into skeleton order
+	UsdPrim skelPrim = stage->GetPrimAtPath(usdSkel.primPath);
+	UsdSkelRoot skelRoot = UsdSkelRoot::Find(skelPrim);
+	if (!skelRoot) {
+		ValidationLog::error("Skeleton is not under a SkelRoot: " + MString(usdSkel.primPath.GetText()));
+		return;
+	}
+
+	UsdSkelCache skelCache;
+	skelCache.Populate(skelRoot, UsdTraverseInstanceProxies(UsdPrimDefaultPredicate));
+	UsdSkelSkeletonQuery skelQuery = skelCache.GetSkelQuery(UsdSkelSkeleton(skelPrim));
+	if (!skelQuery) {
+		ValidationLog::error("Failed to query skeleton: " + MString(usdSkel.primPath.GetText()));
+		return;
+	}
+
+	// Maya frames are in the scene time unit, USD samples in time codes
+	double timeCodesPerSecond = stage->GetTimeCodesPerSecond();
+
+	// Frames are handled in batches to keep the sampled matrices bounded on long ranges
+	const size_t kFramesPerBatch = 64;
+
+	std::pmr::memory_resource* arena = RunArena::current();
+	std::pmr::vector<FrameResult> frameResults(arena);
+	std::pmr::vector<double> frames(arena), timeCodes(arena);
+	// From an integer count, a running sum drifts and can drop or repeat the last frame
+	size_t numFrames = frameStep > 0.0 && endFrame >= startFrame ?
+		static_cast<size_t>(std::floor((endFrame - startFrame) / frameStep + 1e-9)) + 1 : 0;
+	for (size_t i = 0; i < numFrames; ++i) {
+		double frame = startFrame + static_cast<double>(i) * frameStep;
+		frames.push_back(frame);
+		timeCodes.push_back(MTime(frame, MTime::uiUnit()).as(MTime::kSeconds) * timeCodesPerSecond);
+	}
+
+	for (size_t batchBegin = 0; batchBegin < frames.size(); batchBegin += kFramesPerBatch) {
+		size_t batchEnd = std::min(batchBegin + kFramesPerBatch, frames.size());
+		std::pmr::vector<double> batchFrames(frames.begin() + batchBegin, frames.begin() + batchEnd, arena);
+
+		// Maya first, DG evaluation has to stay on the main thread
+		std::vector<MMatrixArray> mayaTransforms;
+		if (parseMayaJointLocalTransforms(mayaSkel, batchFrames, mayaTransforms) != MS::kSuccess) {
+			return;
 		}
+
+		// USD sampling and the comparison run in parallel across the batch's frames
+		std::pmr::vector<FrameResult> batchResults(batchFrames.size(), arena);
+		WorkParallelForN(batchFrames.size(), [&](size_t begin, size_t end) {
+			VtMatrix4dArray usdTransforms;
+			for (size_t f = begin; f < end; ++f) {
+				FrameResult& result = batchResults[f];
+				result = { batchFrames[f], 0, -1, 0.0f };
+
+				if (!skelQuery.ComputeJointLocalTransforms(&usdTransforms, UsdTimeCode(timeCodes[batchBegin + f])) ||
+					usdTransforms.size() != numJoints) {
+					// Every joint fails, an infinite error tells it from a real mismatch
+					result.mismatchCount = static_cast<int>(numJoints);
+					result.firstJoint = 0;
+					result.maxError = std::numeric_limits<float>::infinity();
+					continue;
+				}
+
+				for (size_t j = 0; j < numJoints; ++j) {
+					double maxDiff = 0.0;
+					for (int row = 0; row < 4; ++row) {
+						for (int col = 0; col < 4; ++col) {
+							maxDiff = std::max(maxDiff, std::abs(usdTransforms[j][row][col] - mayaTransforms[f][j](row, col)));
+						}
+					}
+					if (maxDiff > kAnimationTolerance) {
+						if (result.firstJoint < 0) result.firstJoint = static_cast<int>(j);
+						result.mismatchCount++;
+						result.maxError = std::max(result.maxError, static_cast<float>(maxDiff));
+					}
+				}
+			}
+		});
+
+		frameResults.insert(frameResults.end(), batchResults.begin(), batchResults.end());
 	}
-	return true;
+
+	summarizeFrameResults(frameResults, issues);
 }
 
-MMatrix ValidateRigCmd::getBindMatrixForJoint(const MDagPath& jointPath, MStatus& status)
+MStatus ValidateRigCmd::parseMayaJointLocalTransforms(const MayaSkeletonData& mayaSkel,
+	const std::pmr::vector<double>& frames, std::vector<MMatrixArray>& localTransforms)
 {
-	status = MS::kFailure;
+	MStatus status;
+	unsigned int numJoints = mayaSkel.jointPaths.length();
+
+	// Look the plugs up once, then evaluate all of them per frame context
+	std::pmr::vector<MPlug> matrixPlugs(numJoints, RunArena::current());
+	for (unsigned int j = 0; j < numJoints; ++j) {
+		MFnDependencyNode jointNode(mayaSkel.jointPaths[j].node());
+		matrixPlugs[j] = jointNode.findPlug("matrix", true, &status);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+	}
 
-	// Find all skin clusters in the scene
-	MItDependencyNodes itDep(MFn::kSkinClusterFilter, &status);
-	if (status != MS::kSuccess) return MMatrix::identity;
+	localTransforms.assign(frames.size(), MMatrixArray(numJoints));
+	for (size_t f = 0; f < frames.size(); ++f) {
+		MDGContext context(MTime(frames[f], MTime::uiUnit()));
+		MDGContextGuard contextGuard(context);
 
-	MString jointName = jointPath.partialPathName();
+		for (unsigned int j = 0; j < numJoints; ++j) {
+			MObject matrixData = matrixPlugs[j].asMObject(&status);
+			if (status != MS::kSuccess) {
+				MGlobal::displayError("Failed to evaluate local matrix of: " + mayaSkel.jointNames[j]);
+				return status;
+			}
+			localTransforms[f][j] = MFnMatrixData(matrixData).matrix();
+		}
+	}
 
-	while (!itDep.isDone()) {
-		MObject skinClusterObj = itDep.thisNode();
-		MFnSkinCluster skinCluster(skinClusterObj, &status);
-		if (status != MS::kSuccess) {
-			itDep.next();
+	return MS::kSuccess;
+}
+
+void ValidateRigCmd::summarizeFrameResults(const std::pmr::vector<FrameResult>& frameResults, IssueSink& issues)
+{
+	// Collapse consecutive failing frames into one timeline entry
+	size_t i = 0;
+	while (i < frameResults.size()) {
+		if (frameResults[i].mismatchCount == 0) {
+			i++;
 			continue;
 		}
 
-		// Get all influence objects for this skin cluster
-		MDagPathArray influencePaths;
-		int numInfluences = skinCluster.influenceObjects(influencePaths, &status);
-		if (status != MS::kSuccess) {
-			itDep.next();
-			continue;
+		size_t runEnd = i;
+		int maxMismatchCount = 0;
+		float maxError = 0.0f;
+		while (runEnd < frameResults.size() && frameResults[runEnd].mismatchCount > 0) {
+			maxMismatchCount = std::max(maxMismatchCount, frameResults[runEnd].mismatchCount);
+			maxError = std::max(maxError, frameResults[runEnd].maxError);
+			runEnd++;
 		}
 
-		// Check if our joint is an influence
-		for (int i = 0; i < numInfluences; ++i) {
-			if (influencePaths[i].partialPathName() == jointName) {
-				unsigned int logicalIndex = skinCluster.indexForInfluenceObject(influencePaths[i], &status);
-				if (status != MS::kSuccess) {
-					continue;
-				}
+		issues.add(ValidationIssue(ValidationIssue::Type::ANIMATED_TRANSFORM_MISMATCH, frameResults[i].firstJoint,
+			frameResults[i].frame, frameResults[runEnd - 1].frame, maxError, -1, maxMismatchCount));
 
-				MFnDependencyNode skinClusterDepNode(skinClusterObj);
-				MPlug bindPreMatrixPlug = skinClusterDepNode.findPlug("bindPreMatrix", &status);
-				if (status != MS::kSuccess) {
-					continue;
-				}
+		i = runEnd;
+	}
+}
 
-				MPlug matrixPlug = bindPreMatrixPlug.elementByLogicalIndex(logicalIndex, &status);
-				if (status != MS::kSuccess) {
-					continue;
-				}
+int ValidateRigCmd::findSkinBinding(const USDRigData& usdRig, const MString& geomName)
+{
+	for (size_t i = 0; i < usdRig.skinBindings.size(); ++i) {
+		if (usdRig.skinBindings[i].geomPath.GetName() == geomName.asChar()) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
 
-				MObject matrixData;
-				status = matrixPlug.getValue(matrixData);
-				if (status != MS::kSuccess) {
-					continue;
-				}
+MStringArray ValidateRigCmd::describeIssues(const BoundedIssueSink& issues,
+	const USDRigData* usdRig, const MayaRigData* mayaRig)
+{
+	MStringArray descriptions;
+	for (int t = 0; t < BoundedIssueSink::kNumCategories; ++t) {
+		ValidationIssue::Type type = static_cast<ValidationIssue::Type>(t);
+		const BoundedIssueSink::CategoryStats& stats = issues.category(type);
+		for (const ValidationIssue& sample : stats.samples) {
+			descriptions.append(describeIssue(sample, usdRig, mayaRig));
+		}
+
+		uint64_t omitted = stats.count - stats.samples.size();
+		if (omitted > 0) {
+			descriptions.append(describeIssue(ValidationIssue::makeRollUp(type, stats.geomIndex,
+				static_cast<int>(omitted), stats.omittedErrorSum(), stats.maxError), usdRig, mayaRig));
+		}
+	}
+	return descriptions;
+}
+
+void ValidateRigCmd::reportIssues(const BoundedIssueSink& issues,
+	const USDRigData* usdRig, const MayaRigData* mayaRig)
+{
+	reportIssues(issues, describeIssues(issues, usdRig, mayaRig));
+}
+
+void ValidateRigCmd::reportIssues(const BoundedIssueSink& issues, const MStringArray& descriptions)
+{
+	for (unsigned int i = 0; i < descriptions.length(); ++i) {
+		MGlobal::displayWarning(descriptions[i]);
+	}
+
+	// Error spread of the numeric checks, one decade per bin
+	for (int t = 0; t < BoundedIssueSink::kNumCategories; ++t) {
+		ValidationIssue::Type type = static_cast<ValidationIssue::Type>(t);
+		const BoundedIssueSink::CategoryStats& stats = issues.category(type);
+		if (stats.count < 2 || stats.maxError <= 0.0) continue;
+
+		MString bins;
+		for (int b = 0; b < BoundedIssueSink::kHistogramBins; ++b) {
+			bins += (b > 0 ? " " : "");
+			bins += (unsigned int)stats.histogram[b];
+		}
+
+		MString info;
+		info.format("^1s: ^2s issue(s), mean error=^3s, max error=^4s, histogram <1e-6..>=1 [^5s]",
+			MString(issueTypeName(type)),
+			MString() + (unsigned int)stats.count,
+			MString() + stats.meanError(),
+			MString() + stats.maxError,
+			bins);
+		MGlobal::displayInfo(info);
+	}
+
+	if (issues.empty()) {
+		MGlobal::displayInfo("Rig validation passed");
+	}
+	else {
+		MGlobal::displayWarning(MString("Rig validation found ") + (unsigned int)issues.totalCount() + " issue(s)");
+	}
+}
+
+const char* ValidateRigCmd::issueTypeName(ValidationIssue::Type type)
+{
+	switch (type) {
+	case ValidationIssue::Type::JOINT_COUNT_MISMATCH: return "jointCount";
+	case ValidationIssue::Type::JOINT_NAME_MISMATCH: return "jointName";
+	case ValidationIssue::Type::PARENT_INDEX_MISMATCH: return "parentIndex";
+	case ValidationIssue::Type::BIND_TRANSFORM_MISMATCH: return "bindTransform";
+	case ValidationIssue::Type::REST_TRANSFORM_MISMATCH: return "restTransform";
+	case ValidationIssue::Type::WEIGHT_COUNT_MISMATCH: return "weightCount";
+	case ValidationIssue::Type::JOINT_INDEX_MISMATCH: return "jointIndex";
+	case ValidationIssue::Type::WEIGHT_VALUE_MISMATCH: return "weightValue";
+	case ValidationIssue::Type::GEOM_BIND_TRANSFORM_MISMATCH: return "geomBindTransform";
+	case ValidationIssue::Type::SKIN_BINDING_MISSING: return "skinBindingMissing";
+	case ValidationIssue::Type::ANIMATED_TRANSFORM_MISMATCH: return "animatedTransform";
+	case ValidationIssue::Type::INVALID_SKIN_BINDING: return "invalidSkinBinding";
+	}
+	return "unknown";
+}
+
+MString ValidateRigCmd::describeIssue(const ValidationIssue& issue,
+	const USDRigData* usdRig, const MayaRigData* mayaRig)
+{
+	// Names are only available while the rigs the issue was found in are still around
+	const MayaSkeletonData* mayaSkel = mayaRig ? &mayaRig->skeleton : nullptr;
+	const USDSkeletonData* usdSkel = usdRig ? &usdRig->skeleton : nullptr;
+
+	auto mayaJointName = [&](int joint) {
+		if (mayaSkel && joint >= 0 && joint < (int)mayaSkel->jointNames.length()) {
+			return mayaSkel->jointNames[joint];
+		}
+		return MString() + joint;
+	};
+	auto usdJointName = [&](int joint) {
+		if (usdSkel && joint >= 0 && joint < (int)usdSkel->jointNames.size()) {
+			return MString(usdSkel->jointNames[joint].GetString().c_str());
+		}
+		return MString() + joint;
+	};
+
+	auto jointPath = [](const std::vector<int>& jointIds, int joint) {
+		if (joint >= 0 && joint < (int)jointIds.size()) {
+			return MString(JointPathTable::instance().path(jointIds[joint]).c_str());
+		}
+		return MString() + joint;
+	};
+
+	MString geom;
+	if (issue.geomIndex >= 0) {
+		geom = mayaRig && issue.geomIndex < (int)mayaRig->geomNames.length() ?
+			mayaRig->geomNames[issue.geomIndex] : MString() + issue.geomIndex;
+	}
+
+	MString desc;
+	if (issue.rollUp) {
+		desc.format("... and ^1s more ^2s issue(s) (mean error=^3s, max error=^4s)",
+			MString() + issue.count,
+			MString(issueTypeName(issue.type)),
+			MString() + (issue.count > 0 ? issue.expected / issue.count : 0.0),
+			MString() + issue.diff);
+		return issue.geomIndex >= 0 ? "[" + geom + "] " + desc : desc;
+	}
 
-				MFnMatrixData matrixDataFn(matrixData);
-				MMatrix bindPreMatrix = matrixDataFn.matrix(&status);
-				if (status == MS::kSuccess) {
-					return bindPreMatrix;
+	switch (issue.type) {
+	case ValidationIssue::Type::JOINT_COUNT_MISMATCH:
+		desc.format("Joint count mismatch: USD has ^1s joints, Maya has ^2s joints",
+			MString() + (int)issue.expected,
+			MString() + (int)issue.actual);
+		break;
+	case ValidationIssue::Type::JOINT_NAME_MISMATCH:
+		// The paths that were compared, Maya's partial path names would not show the difference
+		desc.format("Joint ^1s name mismatch: USD=''^2s'', Maya=''^3s''",
+			MString() + issue.index,
+			usdSkel ? jointPath(usdSkel->jointIds, issue.index) : usdJointName(issue.index),
+			mayaSkel ? jointPath(mayaSkel->jointIds, issue.index) : mayaJointName(issue.index));
+		if (issue.actual >= 0.0) {
+			desc += " (bind transform matches USD joint ''" +
+				(usdSkel ? jointPath(usdSkel->jointIds, (int)issue.actual) : usdJointName((int)issue.actual)) + "'')";
+		}
+		break;
+	case ValidationIssue::Type::PARENT_INDEX_MISMATCH:
+		desc.format("Joint ^1s parent index mismatch: USD=^2s, Maya^3s",
+			MString() + issue.index,
+			MString() + (int)issue.expected,
+			MString() + (int)issue.actual);
+		break;
+	case ValidationIssue::Type::BIND_TRANSFORM_MISMATCH:
+		desc.format("Joint ^1s (^2s) bind transform mismatch: ^3s",
+			MString() + issue.index,
+			mayaJointName(issue.index),
+			describeTransformErrors(issue));
+		break;
+	case ValidationIssue::Type::REST_TRANSFORM_MISMATCH:
+		desc.format("Joint ^1s (^2s) rest transform mismatch: ^3s",
+			MString() + issue.index,
+			mayaJointName(issue.index),
+			describeTransformErrors(issue));
+		break;
+	case ValidationIssue::Type::INVALID_SKIN_BINDING:
+		desc.format("Invalid USD skin binding: ^1s joint indices, ^2s joint weights",
+			MString() + (int)issue.expected,
+			MString() + (int)issue.actual);
+		break;
+	case ValidationIssue::Type::WEIGHT_COUNT_MISMATCH:
+		desc.format("Skinned vertex count mismatch: USD has ^1s, Maya has ^2s",
+			MString() + (int)issue.expected,
+			MString() + (int)issue.actual);
+		break;
+	case ValidationIssue::Type::JOINT_INDEX_MISMATCH:
+		{
+			// The rows are cheap to read again, so they are not kept on the issue. Streamed
+			// weights are gone by now, re-reading a whole primvar per issue would not be.
+			MString usdJoints("?"), mayaJoints("?");
+			int usdIndex = usdRig && mayaRig ? findSkinBinding(*usdRig, geom) : -1;
+			if (usdIndex >= 0 && !usdRig->skinBindings[usdIndex].weightsDeferred) {
+				SkinRow usdRow, mayaRow;
+				readUSDSkinRow(usdRig->skinBindings[usdIndex], issue.index, usdRow);
+				readMayaSkinRow(mayaRig->skinBindings[issue.geomIndex], issue.index, mayaRow);
+
+				usdJoints = "";
+				mayaJoints = "";
+				for (int j = 0; j < usdRow.size(); ++j) {
+					usdJoints += (j > 0 ? " " : "");
+					usdJoints += usdRow[j].joint;
 				}
+				for (int j = 0; j < mayaRow.size(); ++j) {
+					mayaJoints += (j > 0 ? " " : "");
+					mayaJoints += mayaRow[j].joint;
+				}
+			}
+			desc.format("Joint influence mismatch at vertex ^1s: USD=[^2s], Maya=[^3s]",
+				MString() + issue.index, usdJoints, mayaJoints);
+		}
+		break;
+	case ValidationIssue::Type::WEIGHT_VALUE_MISMATCH:
+		desc.format("Weight mismatch at vertex ^1s (max diff=^2s)",
+			MString() + issue.index,
+			MString() + issue.diff);
+		break;
+	case ValidationIssue::Type::GEOM_BIND_TRANSFORM_MISMATCH:
+		desc = "Geometry bind transform mismatch: " + describeTransformErrors(issue);
+		break;
+	case ValidationIssue::Type::SKIN_BINDING_MISSING:
+		desc.format("Mesh ''^1s'' is skinned in Maya but has no USD skin binding", geom);
+		return desc;
+	case ValidationIssue::Type::ANIMATED_TRANSFORM_MISMATCH:
+		if (std::isinf(issue.diff)) {
+			desc.format("Frames ^1s-^2s: USD joint transforms could not be sampled",
+				MString() + issue.expected,
+				MString() + issue.actual);
+			break;
+		}
+		desc.format("Frames ^1s-^2s: up to ^3s joint(s) animated transform mismatch, first ''^4s'' (max error=^5s)",
+			MString() + issue.expected,
+			MString() + issue.actual,
+			MString() + issue.count,
+			mayaJointName(issue.index),
+			MString() + issue.diff);
+		break;
+	}
+
+	if (issue.geomIndex >= 0) {
+		desc = "[" + geom + "] " + desc;
+	}
+	return desc;
+}
+
+bool ValidateRigCmd::matricesMatch(const GfMatrix4d& usdMat, const MMatrix& mayaMat)
+{
+	// Decomposing is only needed for the matrices the element bounds reject
+	const TolerancePolicy& policy = TolerancePolicy::current();
+	return policy.matches(usdMat, mayaMat) || TransformDecomposition::compare(usdMat, mayaMat, policy).matches;
+}
+
+bool ValidateRigCmd::jointTransformMatches(const GfMatrix4d& usdMat, const MayaSkeletonData& mayaSkel,
+	size_t i, bool bind, TransformDecomposition::Errors* errors)
+{
+	MMatrix restTransform, bindTransform;
+	if (!mayaSkel.compact) {
+		restTransform = bind ? MMatrix() : mayaSkel.restTransforms[i];
+		bindTransform = bind ? mayaSkel.bindTransforms[i] : MMatrix();
+	}
+	else {
+		const CompactMatrixArray& compact = bind ? mayaSkel.compactBindTransforms : mayaSkel.compactRestTransforms;
+		if (!compactMatrixMayDiffer(usdMat, compact, i, TolerancePolicy::current())) return true;
+
+		// The float copy cannot tell, decide on the double matrix from the scene
+		if (parseMayaJoint(mayaSkel.jointPaths[i], mayaSkel.rootWorldInverse,
+			restTransform, bindTransform) != MS::kSuccess) {
+			if (errors) {
+				*errors = TransformDecomposition::Errors();
+				errors->decomposed = false;
+				errors->matches = false;
 			}
+			return false;
 		}
+	}
+
+	const MMatrix& mayaMat = bind ? bindTransform : restTransform;
+	const TolerancePolicy& policy = TolerancePolicy::current();
+	if (policy.matches(usdMat, mayaMat)) return true;
+	TransformDecomposition::Errors decomposed = TransformDecomposition::compare(usdMat, mayaMat, policy);
+	if (errors) *errors = decomposed;
+	return decomposed.matches;
+}
+
+MMatrix ValidateRigCmd::getBindMatrixForJoint(const MDagPath& jointPath, MStatus& status)
+{
+	status = MS::kSuccess;
 
-		itDep.next();
+	// The index located every influence's bindPreMatrix element when it was built
+	MObject skinClusterObj;
+	unsigned int logicalIndex = 0;
+	if (!SceneCache::instance()->skinClusters().bindPreMatrixFor(jointPath, skinClusterObj, logicalIndex)) {
+		// Joint not found in any skin cluster
+		return MMatrix::identity;
 	}
 
-	// Joint not found in any skin cluster
-	return MMatrix::identity;
+	MFnDependencyNode skinClusterDepNode(skinClusterObj, &status);
+	if (status != MS::kSuccess) return MMatrix::identity;
+	MPlug bindPreMatrixPlug = skinClusterDepNode.findPlug("bindPreMatrix", true, &status);
+	if (status != MS::kSuccess) return MMatrix::identity;
+	MPlug matrixPlug = bindPreMatrixPlug.elementByLogicalIndex(logicalIndex, &status);
+	if (status != MS::kSuccess) return MMatrix::identity;
+
+	MObject matrixData;
+	status = matrixPlug.getValue(matrixData);
+	if (status != MS::kSuccess) return MMatrix::identity;
+
+	MFnMatrixData matrixDataFn(matrixData);
+	MMatrix bindPreMatrix = matrixDataFn.matrix(&status);
+	if (status != MS::kSuccess) return MMatrix::identity;
+	return bindPreMatrix;
 }
@@ -1,24 +1,42 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <unordered_map>
+#include <memory_resource>
 #include <maya/MPxCommand.h>
 #include <maya/MString.h>
 #include <maya/MStatus.h>
 #include <maya/MSyntax.h>
 #include <maya/MArgList.h>
+#include <maya/MArgDatabase.h>
 #include <maya/MDagPath.h>
+#include <maya/MDagPathArray.h>
+#include <maya/MObject.h>
 #include <maya/MStringArray.h>
 #include <maya/MIntArray.h>
 #include <maya/MFloatArray.h>
 #include <maya/MMatrixArray.h>
+#include "TolerancePolicy.h"
+#include "TransformDecomposition.h"
+#include "SubtreeHashes.h"
 #include <pxr/pxr.h>
 #include <pxr/usd/sdf/path.h>
+#include <pxr/usd/usd/stage.h>
 #include <pxr/base/tf/token.h>
 #include <pxr/base/vt/array.h>
 #include <pxr/base/gf/matrix4d.h>
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+class ValidationSession;
+class IssueSink;
+class BoundedIssueSink;
+class ValidationJob;
+class ValidationBatch;
+class SkinClusterIndex;
+class InfluenceIndex;
+
 class ValidateRigCmd : public MPxCommand 
 {
 public:
@@ -39,9 +57,11 @@ public:
 	struct USDSkeletonData {
 		SdfPath primPath;
 		VtTokenArray jointNames;
+		std::vector<int> jointIds; // JointPathTable ids of the normalized joint names
 		VtArray<int> jointParentIndices;
 		VtArray<GfMatrix4d> bindTransforms;
 		VtArray<GfMatrix4d> restTransforms;
+		SubtreeHashes subtrees; // Built by hashSubtrees when parsed
 	};
 
 	struct USDSkinBindingData {
@@ -49,44 +69,86 @@ public:
 		SdfPath geomPath;
 		VtArray<int> jointIndices;
 		VtArray<float> jointWeights;
+		int elementSize = 0; // Influences stored per vertex
+		bool constant = false; // Constant interpolation, the one row applies to every vertex
 		GfMatrix4d geomBindTransform;
+		bool weightsDeferred = false; // -streamSkins: the arrays above are only read while validating
+		std::vector<int> jointRemap;  // skel:joints entry to skeleton joint, empty when the binding has none
+	};
+
+	// Float32 copy of a matrix array stored as one array per matrix element, so a kernel
+	// comparing one element across joints reads contiguous memory
+	struct CompactMatrixArray {
+		std::vector<float> elements[16];
+
+		size_t size() const { return elements[0].size(); }
+		void resize(size_t n) { for (std::vector<float>& element : elements) element.resize(n); }
+		void set(size_t i, const MMatrix& m) {
+			for (int k = 0; k < 16; ++k) elements[k][i] = static_cast<float>(m(k / 4, k % 4));
+		}
+		float get(size_t i, int row, int col) const { return elements[row * 4 + col][i]; }
 	};
 
 	struct MayaSkeletonData {
 		MDagPath rootPath;
+		MDagPathArray jointPaths;
 		MStringArray jointNames;
+		std::vector<int> jointIds; // JointPathTable ids of the paths from the root joint
 		MIntArray jointParentIndices;
 		MMatrixArray bindTransforms;
 		MMatrixArray restTransforms;
+
+		// -compact: the transforms are only kept as float32 below and the arrays above stay
+		// empty. Joints the float screen cannot clear are read from Maya again in double.
+		bool compact = false;
+		CompactMatrixArray compactBindTransforms;
+		CompactMatrixArray compactRestTransforms;
+		MMatrix rootWorldInverse;
+
+		// Built by hashSubtrees when parsed, left empty for compact transforms. Whoever edits
+		// the transforms afterwards clears it.
+		SubtreeHashes subtrees;
 	};
 
 	struct MayaSkinBindingData {
 		MDagPath skelPath;
 		MDagPath geomPath;
-		MIntArray jointIndices;
+		MIntArray jointIndices; // Skeleton joint indices, influence slots when extracted without an InfluenceIndex
 		MFloatArray jointWeights;
-		MMatrix geomBindTransform;
+		MIntArray vertexOffsets; // Row start of each vertex in jointIndices/jointWeights, plus end
+		MMatrix geomBindTransform; // The skin cluster's geomMatrix, the mesh's world matrix when bound
+		MObject skinClusterNode;
 	};
 
-private:
-	static const char* rootFlag;
-	static const char* rootFlagLong;
-	static const char* pathFlag;
-	static const char* pathFlagLong;
-
-	MDagPath m_root;
-	MString m_usdFilePath;
-
-	std::unique_ptr<USDSkeletonData> parseUSDSkelData(const MString& filePath, const SdfPath& skelPath);
-	std::vector<USDSkeletonData> parseAllUSDSkels(const MString& filePath);
-	std::unique_ptr<MayaSkeletonData> parseMayaSkel(const MDagPath& root);
-	std::unique_ptr<MayaSkinBindingData> parseMayaSkin(const MDagPath& meshPath);
+	// Everything compared for one skeleton, gathered from each side
+	struct USDRigData {
+		USDSkeletonData skeleton;
+		std::vector<USDSkinBindingData> skinBindings;
+		UsdStageRefPtr stage; // Kept open for deferred skin weights
+	};
 
-	bool quickValidateSkeleton(const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel);
-	bool quickValidateSkinBinding(const USDSkinBindingData& usdSkin, const MayaSkinBindingData& mayaSkin);
+	struct MayaRigData {
+		MayaSkeletonData skeleton;
+		std::vector<MayaSkinBindingData> skinBindings;
+		MStringArray geomNames; // Transform name of each skinBindings entry, used to pair with USD prims
+	};
 
+	// A single finding, kept as plain numbers so that building and streaming large reports
+	// stays cheap. Text is only rendered by describeIssue when someone displays it.
+	//
+	// expected/actual hold the USD/Maya value where the check has one: joint or vertex
+	// counts, parent indices, and the first/last frame for ANIMATED_TRANSFORM_MISMATCH.
+	// diff is the largest absolute difference of the compared values.
+	//
+	// Transform mismatches hold the errors of the decomposed transforms instead: expected
+	// is the translation, actual the rotation angle in radians and scaleDiff the scale.
+	// actual is -1 when either matrix has shear or perspective and was not decomposed.
+	//
+	// A roll-up stands for count issues of its type that a bounded sink did not keep,
+	// with the sum of their errors in expected and their max error in diff. A sum rather
+	// than a mean, so roll-ups merged into another sink add up exactly.
 	struct ValidationIssue {
-		enum class Type {
+		enum class Type : unsigned char {
 			JOINT_COUNT_MISMATCH,
 			JOINT_NAME_MISMATCH,
 			PARENT_INDEX_MISMATCH,
@@ -95,29 +157,231 @@ private:
 			WEIGHT_COUNT_MISMATCH,
 			JOINT_INDEX_MISMATCH,
 			WEIGHT_VALUE_MISMATCH,
-			GEOM_BIND_TRANSFORM_MISMATCH
+			GEOM_BIND_TRANSFORM_MISMATCH,
+			SKIN_BINDING_MISSING,
+			ANIMATED_TRANSFORM_MISMATCH,
+			INVALID_SKIN_BINDING // Keep last, kLastType and the per category tables follow it
 		};
+		static const Type kLastType = Type::INVALID_SKIN_BINDING;
 
 		Type type;
-		MString description;
-		int index;
+		bool rollUp;
+		int index;     // Joint or vertex, -1 when the issue covers a whole skeleton or mesh
+		int geomIndex; // Entry of MayaRigData::skinBindings, -1 for skeleton issues
+		int count;     // Joints for ANIMATED_TRANSFORM_MISMATCH, issues left out for roll-ups
+		double expected;
+		double actual;
+		double diff;
+		float scaleDiff;
+
+		ValidationIssue(Type t, int idx = -1, double exp = 0.0, double act = 0.0, double d = 0.0,
+			int geom = -1, int n = 1) :
+			type(t), rollUp(false), index(idx), geomIndex(geom), count(n), expected(exp), actual(act), diff(d),
+			scaleDiff(0.0f) {}
 
-		ValidationIssue(Type t, const MString& desc, int idx = -1) :
-			type(t), description(desc), index(idx) {}
+		static ValidationIssue makeRollUp(Type t, int geom, int omitted, double errorSum, double maxError) {
+			ValidationIssue issue(t, -1, errorSum, 0.0, maxError, geom, omitted);
+			issue.rollUp = true;
+			return issue;
+		}
+
+		static ValidationIssue makeTransformMismatch(Type t, int idx, const TransformDecomposition::Errors& errors,
+			int geom = -1) {
+			ValidationIssue issue(t, idx, errors.translation, errors.decomposed ? errors.rotation : -1.0,
+				errors.element, geom);
+			issue.scaleDiff = static_cast<float>(errors.scale);
+			return issue;
+		}
 	};
 
-	std::vector<ValidationIssue> detailedValidateSkeleton(
+	static const char* issueTypeName(ValidationIssue::Type type);
+
+	// Renders an issue as text, names are looked up in the rigs when they are given
+	static MString describeIssue(const ValidationIssue& issue,
+		const USDRigData* usdRig, const MayaRigData* mayaRig);
+
+	// Releases the resident -incremental session and its callbacks
+	static void clearSession();
+
+	// Cancels and releases every -async job
+	static void clearJobs();
+
+private:
+	friend class ValidationSession;
+	friend class ValidationJob;
+	friend class ValidationBatch;
+	friend class InfluenceIndex;
+
+	static const char* rootFlag;
+	static const char* rootFlagLong;
+	static const char* pathFlag;
+	static const char* pathFlagLong;
+	static const char* incrementalFlag;
+	static const char* incrementalFlagLong;
+	static const char* clearSessionFlag;
+	static const char* clearSessionFlagLong;
+	static const char* asyncFlag;
+	static const char* asyncFlagLong;
+	static const char* jobStatusFlag;
+	static const char* jobStatusFlagLong;
+	static const char* progressFlag;
+	static const char* progressFlagLong;
+	static const char* cancelFlag;
+	static const char* cancelFlagLong;
+	static const char* resultFlag;
+	static const char* resultFlagLong;
+	static const char* frameRangeFlag;
+	static const char* frameRangeFlagLong;
+	static const char* frameStepFlag;
+	static const char* frameStepFlagLong;
+	static const char* reportFlag;
+	static const char* reportFlagLong;
+	static const char* maxSamplesFlag;
+	static const char* maxSamplesFlagLong;
+	static const char* manifestFlag;
+	static const char* manifestFlagLong;
+	static const char* resultCacheFlag;
+	static const char* resultCacheFlagLong;
+	static const char* streamSkinsFlag;
+	static const char* streamSkinsFlagLong;
+	static const char* compactFlag;
+	static const char* compactFlagLong;
+	static const char* matchSkeletonsFlag;
+	static const char* matchSkeletonsFlagLong;
+	static const char* linearToleranceFlag;
+	static const char* linearToleranceFlagLong;
+	static const char* translationToleranceFlag;
+	static const char* translationToleranceFlagLong;
+	static const char* scaleToleranceFlag;
+	static const char* scaleToleranceFlagLong;
+	static const char* rotationToleranceFlag;
+	static const char* rotationToleranceFlagLong;
+
+	MDagPath m_root;
+	MString m_usdFilePath;
+	bool m_incremental;
+	bool m_async;
+	bool m_animated;
+	double m_startFrame;
+	double m_endFrame;
+	double m_frameStep;
+	MString m_reportPath;
+	int m_maxSamples;
+	MString m_manifestPath;
+	MString m_resultCachePath;
+	bool m_streamSkins;
+	bool m_compact;
+	bool m_matchSkeletons;
+	TolerancePolicy m_tolerance;
+
+	MStatus parseArgs(const MArgDatabase& argData);
+	MStatus doJobQuery(const MArgDatabase& argData);
+	MStatus doBatch();
+
+	// Every tolerance and option a validation result depends on, for ResultCache keys
+	static std::vector<double> cacheSettings(int sampleLimit, bool animated,
+		double startFrame, double endFrame, double frameStep);
+
+	// The file path overloads open the stage once and pass it down, the stage overloads read
+	// one that is already open, e.g. shared by every pair of a batch reading that file
+	static UsdStageRefPtr openUSDStage(const MString& filePath);
+	static std::unique_ptr<USDSkeletonData> parseUSDSkelData(const MString& filePath, const SdfPath& skelPath);
+	static std::unique_ptr<USDSkeletonData> parseUSDSkelData(const UsdStageRefPtr& stage, const SdfPath& skelPath);
+	static std::vector<USDSkeletonData> parseAllUSDSkels(const MString& filePath);
+	static std::vector<USDSkeletonData> parseAllUSDSkels(const UsdStageRefPtr& stage, const MString& filePath);
+	static std::vector<USDSkinBindingData> parseUSDSkinBindings(const UsdStageRefPtr& stage, const SdfPath& skelPath,
+		bool deferWeights = false);
+	static bool readUSDSkinWeights(const UsdPrim& prim, USDSkinBindingData& binding);
+	static std::unique_ptr<USDRigData> parseUSDRig(const MString& filePath, const MString& rootName,
+		bool streamSkins = false, const SdfPath& skelPath = SdfPath());
+	static std::unique_ptr<USDRigData> parseUSDRig(const UsdStageRefPtr& stage, const MString& filePath,
+		const MString& rootName, bool streamSkins = false, const SdfPath& skelPath = SdfPath());
+	static std::unique_ptr<MayaSkeletonData> parseMayaSkel(const MDagPath& root, bool compact = false);
+	static MStatus parseMayaJointHierarchy(const MDagPath& root, MayaSkeletonData& skelData);
+	static MStatus parseMayaJoint(const MDagPath& jointPath, const MMatrix& rootWorldInverse,
+		MMatrix& restTransform, MMatrix& bindTransform);
+	static std::unique_ptr<MayaSkinBindingData> parseMayaSkin(const MDagPath& meshPath,
+		InfluenceIndex* influences = nullptr);
+	static std::unique_ptr<MayaSkinBindingData> parseMayaSkin(const MDagPath& meshPath, const MObject& skinClusterObj,
+		InfluenceIndex* influences = nullptr);
+	static std::unique_ptr<MayaRigData> parseMayaRig(const MDagPath& root, bool compact = false);
+	static std::unique_ptr<MayaRigData> parseMayaRig(const MDagPath& root, const SkinClusterIndex& skinClusters,
+		bool compact = false);
+	static MObject findSkinCluster(const MDagPath& meshPath);
+	static MStatus readGeomBindTransform(const MObject& skinClusterObj, MMatrix& geomBindTransform);
+	static MDagPathArray findSkinnedMeshes(const MDagPath& root);
+	static MString geomName(const MDagPath& meshPath);
+
+	// Merkle hashes of the joints under policy, see SubtreeHashes
+	static void hashSubtrees(const USDSkeletonData& skel, const TolerancePolicy& policy, SubtreeHashes& subtrees);
+	static void hashSubtrees(const MayaSkeletonData& skel, const TolerancePolicy& policy, SubtreeHashes& subtrees);
+
+	static bool quickValidateSkeleton(const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel);
+
+	// Joints the skeleton checks have to visit in order: those outside subtrees whose hashes
+	// agree under the current policy, or all of them when there are no hashes to go by
+	static void jointsToCompare(const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel,
+		std::pmr::vector<int>& joints);
+	static bool quickValidateSkinBinding(const USDSkinBindingData& usdSkin, const MayaSkinBindingData& mayaSkin);
+
+	static void detailedValidateSkeleton(
 		const USDSkeletonData& usdSkel,
-		const MayaSkeletonData& mayaSkel
+		const MayaSkeletonData& mayaSkel,
+		IssueSink& issues
 	);
-	std::vector<ValidationIssue> detailedValidateSkinBinding(
+	// TolerancePolicy::quantizedHash of a bind transform to the joints that have it
+	typedef std::unordered_multimap<uint64_t, int> MatrixBuckets;
+
+	static void detailedValidateJoint(
+		const USDSkeletonData& usdSkel,
+		const MayaSkeletonData& mayaSkel,
+		size_t jointIndex,
+		IssueSink& issues,
+		const MatrixBuckets* usdBindBuckets = nullptr,
+		const TransformDecomposition::Errors* bindErrors = nullptr,
+		const TransformDecomposition::Errors* restErrors = nullptr
+	);
+	static void detailedValidateSkinBinding(
 		const USDSkinBindingData& usdSkin,
-		const MayaSkinBindingData& mayaSkin
+		const MayaSkinBindingData& mayaSkin,
+		int geomIndex,
+		IssueSink& issues
 	);
+	static void validateRig(const USDRigData& usdRig, const MayaRigData& mayaRig, IssueSink& issues);
+	static void validateSkin(const USDRigData& usdRig, const MayaRigData& mayaRig,
+		size_t skinIndex, IssueSink& issues, bool checkGeomBind = true);
+	static void validateGeomBindTransforms(const USDRigData& usdRig, const MayaRigData& mayaRig,
+		size_t skinBegin, size_t skinEnd, IssueSink& issues);
+	static int findSkinBinding(const USDRigData& usdRig, const MString& geomName);
+
+	// One sampled frame of -frameRange validation
+	struct FrameResult {
+		double frame;
+		int mismatchCount;
+		int firstJoint;
+		float maxError;
+	};
+
+	static void validateAnimation(const MString& filePath,
+		const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel,
+		double startFrame, double endFrame, double frameStep, IssueSink& issues);
+	static void validateAnimation(const UsdStageRefPtr& stage,
+		const USDSkeletonData& usdSkel, const MayaSkeletonData& mayaSkel,
+		double startFrame, double endFrame, double frameStep, IssueSink& issues);
+	static MStatus parseMayaJointLocalTransforms(const MayaSkeletonData& mayaSkel,
+		const std::pmr::vector<double>& frames, std::vector<MMatrixArray>& localTransforms);
+	static void summarizeFrameResults(const std::pmr::vector<FrameResult>& frameResults, IssueSink& issues);
+	static MStringArray describeIssues(const BoundedIssueSink& issues,
+		const USDRigData* usdRig, const MayaRigData* mayaRig);
+	static void reportIssues(const BoundedIssueSink& issues,
+		const USDRigData* usdRig, const MayaRigData* mayaRig);
+	// With the descriptions rendered earlier, once the rigs are gone
+	static void reportIssues(const BoundedIssueSink& issues, const MStringArray& descriptions);
 
-	static bool matricesMatch(const GfMatrix4d& usdMat,
-		const MMatrix& mayaMat,
-		double tolerance = 1e-6);
+	// Under TolerancePolicy::current()
+	static bool matricesMatch(const GfMatrix4d& usdMat, const MMatrix& mayaMat);
+	static bool jointTransformMatches(const GfMatrix4d& usdMat, const MayaSkeletonData& mayaSkel,
+		size_t jointIndex, bool bind, TransformDecomposition::Errors* errors = nullptr);
 
-	MMatrix getBindMatrixForJoint(const MDagPath& jointPath, MStatus& status);
+	static MMatrix getBindMatrixForJoint(const MDagPath& jointPath, MStatus& status);
 };
\ No newline at end of file
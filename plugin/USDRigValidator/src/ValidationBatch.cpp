@@ -0,0 +1,369 @@
+#include "ValidationBatch.h"
+#include "RunArena.h"
+#include "SceneCache.h"
+#include "SkeletonMatcher.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <maya/MGlobal.h>
+#include <maya/MFnDagNode.h>
+#include <maya/MSelectionList.h>
+#include <maya/MItDag.h>
+#include <maya/MDagPathArray.h>
+#include <pxr/base/work/dispatcher.h>
+#include <pxr/base/work/threadLimits.h>
+
+namespace {
+
+std::string trim(const std::string& value)
+{
+	size_t begin = value.find_first_not_of(" \t\r\n");
+	if (begin == std::string::npos) return std::string();
+	size_t end = value.find_last_not_of(" \t\r\n");
+	return value.substr(begin, end - begin + 1);
+}
+
+}
+
+ValidationBatch::ValidationBatch(int sampleLimit) :
+	m_sampleLimit(sampleLimit),
+	m_animated(false), m_startFrame(0.0), m_endFrame(0.0), m_frameStep(1.0),
+	m_streamSkins(false), m_compact(false), m_cache(nullptr)
+{
+}
+
+MStatus ValidationBatch::loadManifest(const MString& manifestPath)
+{
+	std::ifstream manifest(manifestPath.asChar());
+	if (!manifest.is_open()) {
+		MGlobal::displayError("Could not open manifest: " + manifestPath);
+		return MS::kInvalidParameter;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+	while (std::getline(manifest, line)) {
+		lineNumber++;
+		line = trim(line);
+		if (line.empty() || line[0] == '#') continue;
+
+		// Maya node names cannot hold whitespace, file paths can
+		size_t split = line.find_last_of(" \t");
+		if (split == std::string::npos) {
+			MGlobal::displayError(MString("Manifest line ") + lineNumber + " needs a USD file and a Maya root");
+			return MS::kInvalidParameter;
+		}
+
+		Entry entry;
+		entry.usdFilePath = trim(line.substr(0, split)).c_str();
+		entry.rootName = line.substr(split + 1).c_str();
+		entry.issues = BoundedIssueSink(m_sampleLimit);
+		m_entries.push_back(std::move(entry));
+	}
+
+	if (m_entries.empty()) {
+		MGlobal::displayWarning("Manifest lists no pairs: " + manifestPath);
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus ValidationBatch::matchSkeletons(const MString& usdFilePath)
+{
+	// The skeletons are read on a worker while the main thread walks the scene for roots
+	const TolerancePolicy& policy = TolerancePolicy::current();
+	auto usdFuture = std::async(std::launch::async, [this, &usdFilePath, &policy]() {
+		ValidationLog::ScopedThreadBuffer logScope(&m_messages);
+		TolerancePolicy::Scope toleranceScope(policy);
+		return ValidateRigCmd::parseAllUSDSkels(usdFilePath);
+	});
+
+	// A joint whose parent is not a joint starts a hierarchy, nothing below it is a root
+	MDagPathArray roots;
+	MItDag dagIt(MItDag::kDepthFirst, MFn::kJoint);
+	for (; !dagIt.isDone(); dagIt.next()) {
+		MDagPath jointPath;
+		dagIt.getPath(jointPath);
+		MDagPath parentPath = jointPath;
+		parentPath.pop();
+		if (parentPath.length() > 0 && parentPath.hasFn(MFn::kJoint)) continue;
+
+		roots.append(jointPath);
+		dagIt.prune();
+	}
+
+	std::vector<SkeletonMatcher::Signature> usdSignatures, mayaSignatures;
+	for (unsigned int i = 0; i < roots.length(); ++i) {
+		// Only the hierarchy, the transforms are extracted once the pair is validated
+		ValidateRigCmd::MayaSkeletonData mayaSkel;
+		ValidateRigCmd::parseMayaJointHierarchy(roots[i], mayaSkel);
+		mayaSignatures.push_back(SkeletonMatcher::signature(mayaSkel, roots[i]));
+	}
+
+	std::vector<ValidateRigCmd::USDSkeletonData> usdSkels = usdFuture.get();
+	m_messages.flush();
+	if (usdSkels.empty()) return MS::kFailure;
+	for (const ValidateRigCmd::USDSkeletonData& usdSkel : usdSkels) {
+		usdSignatures.push_back(SkeletonMatcher::signature(usdSkel));
+	}
+
+	std::vector<char> usdMatched(usdSkels.size(), 0), mayaMatched(roots.length(), 0);
+	for (const auto& pair : SkeletonMatcher::match(usdSignatures, mayaSignatures)) {
+		Entry entry;
+		entry.usdFilePath = usdFilePath;
+		entry.rootName = roots[pair.second].fullPathName();
+		entry.skelPath = usdSkels[pair.first].primPath;
+		entry.issues = BoundedIssueSink(m_sampleLimit);
+		m_entries.push_back(std::move(entry));
+		usdMatched[pair.first] = 1;
+		mayaMatched[pair.second] = 1;
+	}
+
+	for (size_t i = 0; i < usdSkels.size(); ++i) {
+		if (!usdMatched[i]) {
+			MGlobal::displayWarning("No root joint in the scene for USD skeleton " +
+				MString(usdSkels[i].primPath.GetText()));
+		}
+	}
+	for (unsigned int i = 0; i < roots.length(); ++i) {
+		if (!mayaMatched[i]) {
+			MGlobal::displayWarning("No USD skeleton for root joint " + roots[i].fullPathName());
+		}
+	}
+
+	MString summary;
+	summary.format("Matched ^1s USD skeleton(s) to root joints in the scene",
+		MString() + (unsigned int)m_entries.size());
+	MGlobal::displayInfo(summary);
+
+	return MS::kSuccess;
+}
+
+void ValidationBatch::setFrameRange(double startFrame, double endFrame, double frameStep)
+{
+	m_animated = true;
+	m_startFrame = startFrame;
+	m_endFrame = endFrame;
+	m_frameStep = frameStep;
+}
+
+void ValidationBatch::setResultCache(const ResultCache* cache, const std::vector<double>& settings)
+{
+	m_cache = cache;
+	m_cacheSettings = settings;
+}
+
+MStatus ValidationBatch::run(ReportWriter* writer)
+{
+	// Roots are looked up first so the USD workers only see pairs that can be compared, and
+	// the pairs reading each file are counted so its stage can go with the last of them
+	std::vector<MString> jointNames(m_entries.size());
+	std::vector<SharedStage*> stages(m_entries.size(), nullptr);
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		Entry& entry = m_entries[i];
+		MSelectionList selection;
+		if (selection.add(entry.rootName) == MS::kSuccess && selection.getDagPath(0, entry.root) == MS::kSuccess) {
+			entry.resolved = true;
+			jointNames[i] = MFnDagNode(entry.root).name();
+
+			std::unique_ptr<SharedStage>& shared = m_stages[entry.usdFilePath.asChar()];
+			if (!shared) shared = std::make_unique<SharedStage>();
+			shared->pending++;
+			stages[i] = shared.get();
+		}
+		else {
+			MGlobal::displayError("Root joint not found: " + entry.rootName);
+		}
+	}
+
+	// Pairs are independent, so with nothing that has to stay in order the workers compare
+	// them as well. -frameRange evaluates the scene and -compact re-reads joints from it,
+	// both only on the main thread.
+	const bool compareOnWorkers = !writer && !m_animated && !m_compact;
+
+	std::mutex readyMutex;
+	std::condition_variable readyChanged;
+	std::vector<char> ready(m_entries.size(), 0);
+	std::vector<char> compared(m_entries.size(), 0);
+	auto markReady = [&readyMutex, &readyChanged, &ready](size_t i) {
+		std::lock_guard<std::mutex> lock(readyMutex);
+		ready[i] = 1;
+		readyChanged.notify_one();
+	};
+
+	// A cache key includes the Maya rig, so each pair is queued once the main thread has
+	// extracted its rig and the reads run behind the extraction instead of after all of it
+	const TolerancePolicy& policy = TolerancePolicy::current();
+	WorkDispatcher usdReads;
+	auto readUSDRig = [&](size_t i) {
+		auto read = [&, i]() {
+			{
+				ValidationLog::ScopedThreadBuffer logScope(&m_messages);
+				TolerancePolicy::Scope toleranceScope(policy);
+				Entry& entry = m_entries[i];
+				if (m_cache) {
+					entry.cacheKey = m_cache->key(entry.usdFilePath, *entry.mayaRig, m_cacheSettings,
+						entry.skelPath.GetString());
+					entry.cached = m_cache->lookup(entry.cacheKey, entry.issues);
+				}
+				if (!entry.cached) {
+					SharedStage& shared = *stages[i];
+					std::call_once(shared.opened, [&shared, &entry]() {
+						shared.stage = ValidateRigCmd::openUSDStage(entry.usdFilePath);
+					});
+					if (shared.stage) {
+						entry.usdRig = ValidateRigCmd::parseUSDRig(shared.stage, entry.usdFilePath, jointNames[i],
+							m_streamSkins, entry.skelPath);
+					}
+				}
+
+				// Only the messages are needed from here on, the rigs go before the pair is reported
+				if (compareOnWorkers && entry.usdRig) {
+					RunArena arena;
+					RunArena::Scope arenaScope(arena);
+					ValidateRigCmd::validateRig(*entry.usdRig, *entry.mayaRig, entry.issues);
+					entry.descriptions = ValidateRigCmd::describeIssues(entry.issues, entry.usdRig.get(),
+						entry.mayaRig.get());
+					entry.usdRig.reset();
+					entry.mayaRig.reset();
+					compared[i] = 1;
+				}
+			}
+			markReady(i);
+		};
+
+		// A pool without worker threads would only run the reads once waited on
+		if (WorkHasConcurrency()) {
+			usdReads.Run(read);
+		}
+		else {
+			read();
+		}
+	};
+
+	auto reportPair = [&](size_t i) {
+		Entry& entry = m_entries[i];
+		MString heading;
+		heading.format("Validating ''^1s'' against ''^2s''", entry.rootName, entry.usdFilePath);
+		MGlobal::displayInfo(heading);
+
+		if (!entry.cached && !compared[i] && (!entry.usdRig || !entry.mayaRig)) {
+			MGlobal::displayError("Skipped, the rig could not be read: " + entry.rootName);
+			return;
+		}
+
+		// Scratch memory is released pair by pair, a long manifest does not accumulate it
+		RunArena arena;
+		RunArena::Scope arenaScope(arena);
+
+		if (writer) {
+			writer->writeHeader(entry.usdFilePath, entry.rootName, entry.mayaRig->geomNames);
+		}
+
+		if (entry.cached) {
+			MGlobal::displayInfo("Result taken from the cache");
+			if (writer) writer->merge(entry.issues);
+		}
+		else {
+			if (!compared[i]) {
+				IssueSink* sink = &entry.issues;
+				std::unique_ptr<TeeIssueSink> tee;
+				if (writer) {
+					tee = std::make_unique<TeeIssueSink>(entry.issues, *writer);
+					sink = tee.get();
+				}
+
+				ValidateRigCmd::validateRig(*entry.usdRig, *entry.mayaRig, *sink);
+				if (m_animated) {
+					ValidateRigCmd::validateAnimation(stages[i]->stage, entry.usdRig->skeleton,
+						entry.mayaRig->skeleton, m_startFrame, m_endFrame, m_frameStep, *sink);
+				}
+			}
+
+			if (m_cache) {
+				m_cache->store(entry.cacheKey, entry.issues);
+			}
+		}
+		entry.validated = true;
+
+		if (compared[i]) {
+			ValidateRigCmd::reportIssues(entry.issues, entry.descriptions);
+			entry.descriptions.clear();
+		}
+		else {
+			ValidateRigCmd::reportIssues(entry.issues, entry.usdRig.get(), entry.mayaRig.get());
+		}
+	};
+
+	// Reports the pairs whose reads are done in manifest order, waiting for them until at
+	// least count pairs are reported
+	size_t reported = 0;
+	auto reportUntil = [&](size_t count) {
+		while (reported < m_entries.size()) {
+			{
+				std::unique_lock<std::mutex> lock(readyMutex);
+				if (reported >= count && !ready[reported]) return;
+				readyChanged.wait(lock, [&ready, &reported]() { return ready[reported] != 0; });
+			}
+			m_messages.flush();
+			reportPair(reported);
+
+			// The extracted rigs are only needed to render the messages above
+			Entry& entry = m_entries[reported];
+			entry.usdRig.reset();
+			entry.mayaRig.reset();
+			SharedStage* shared = stages[reported];
+			if (shared && --shared->pending == 0) {
+				shared->stage = UsdStageRefPtr();
+			}
+			reported++;
+		}
+	};
+
+	const size_t maxInFlight = kPairsInFlightPerThread * WorkGetConcurrencyLimit();
+	const SkinClusterIndex& skinClusters = SceneCache::instance()->skinClusters();
+	for (size_t i = 0; i < m_entries.size(); ++i) {
+		Entry& entry = m_entries[i];
+		if (entry.resolved) {
+			RunArena arena;
+			RunArena::Scope arenaScope(arena);
+			entry.mayaRig = ValidateRigCmd::parseMayaRig(entry.root, skinClusters, m_compact);
+		}
+		if (entry.mayaRig) {
+			readUSDRig(i);
+		}
+		else {
+			markReady(i);
+		}
+		reportUntil(i + 1 > maxInFlight ? i + 1 - maxInFlight : 0);
+	}
+	reportUntil(m_entries.size());
+
+	usdReads.Wait();
+	m_messages.flush();
+	m_stages.clear();
+	if (m_cache) {
+		m_cache->trim();
+	}
+
+	MString summary;
+	summary.format("Batch validation: ^1s of ^2s pair(s) passed",
+		MString() + (unsigned int)(m_entries.size() - numFailed()),
+		MString() + (unsigned int)m_entries.size());
+	MGlobal::displayInfo(summary);
+
+	return MS::kSuccess;
+}
+
+unsigned int ValidationBatch::numFailed() const
+{
+	unsigned int numFailed = 0;
+	for (const Entry& entry : m_entries) {
+		if (!entry.validated || !entry.issues.empty()) numFailed++;
+	}
+	return numFailed;
+}
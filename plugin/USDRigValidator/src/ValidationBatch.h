@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+#include "ValidationLog.h"
+#include "ValidationReport.h"
+#include "ResultCache.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <maya/MDagPath.h>
+#include <maya/MString.h>
+#include <maya/MStringArray.h>
+#include <pxr/usd/usd/stage.h>
+#include <pxr/usd/sdf/path.h>
+
+// A validateRig -manifest or -matchSkeletons run over many (USD file, Maya root) pairs.
+// Scene wide work is done once for the whole batch: skin clusters are indexed in a
+// single DG pass, each USD file is opened once and its stage shared by the pairs reading
+// it, and the USD rigs are parsed on the work pool while the main thread extracts the
+// Maya rigs. A pair is compared as soon as both of its rigs are read and released once
+// reported, a stage once no pair left in the queue reads its file.
+class ValidationBatch
+{
+public:
+	struct Entry {
+		MString usdFilePath;
+		MString rootName;
+		MDagPath root;
+		SdfPath skelPath;       // USD skeleton paired with the root, empty to pick it by the root's name
+		bool resolved = false;  // Root found in the scene
+		bool validated = false; // Both rigs compared, or the result taken from the cache
+		bool cached = false;    // Issues taken from the result cache, the USD rig was never parsed
+		std::string cacheKey;
+
+		std::unique_ptr<ValidateRigCmd::USDRigData> usdRig;
+		std::unique_ptr<ValidateRigCmd::MayaRigData> mayaRig;
+		BoundedIssueSink issues;
+		MStringArray descriptions; // Rendered by the worker that compared the pair, the rigs are gone by then
+	};
+
+	explicit ValidationBatch(int sampleLimit);
+
+	// One pair per line, the USD file then the Maya root separated by whitespace.
+	// Blank lines and lines starting with # are skipped.
+	MStatus loadManifest(const MString& manifestPath);
+
+	// Instead of a manifest, pairs every skeleton in the USD file with a root joint of the
+	// scene through SkeletonMatcher. Skeletons and roots left without a partner are reported.
+	MStatus matchSkeletons(const MString& usdFilePath);
+
+	void setFrameRange(double startFrame, double endFrame, double frameStep);
+
+	// Skin weights are read per mesh while comparing instead of with each USD rig up front
+	void setStreamSkins(bool streamSkins) { m_streamSkins = streamSkins; }
+
+	// Maya joint transforms are extracted as float32, see MayaSkeletonData::compact
+	void setCompact(bool compact) { m_compact = compact; }
+
+	// Pairs whose layers and Maya rig are unchanged since a cached run skip USD parsing and
+	// comparison. The cache must outlive run().
+	void setResultCache(const ResultCache* cache, const std::vector<double>& settings);
+
+	// Validates every pair and displays the results in manifest order. Pairs are compared
+	// on the work pool unless a writer, a frame range or compact transforms need the main
+	// thread or a fixed order. With a writer every issue is streamed there, after a header
+	// per pair.
+	MStatus run(ReportWriter* writer);
+
+	const std::vector<Entry>& entries() const { return m_entries; }
+
+	// Pairs that could not be validated or had issues
+	unsigned int numFailed() const;
+
+private:
+	int m_sampleLimit;
+	std::vector<Entry> m_entries;
+
+	bool m_animated;
+	double m_startFrame;
+	double m_endFrame;
+	double m_frameStep;
+	bool m_streamSkins;
+	bool m_compact;
+
+	const ResultCache* m_cache;
+	std::vector<double> m_cacheSettings;
+
+	// One per distinct USD file. The first worker to need the stage opens it, the main thread
+	// releases it when the last pair reading the file has been reported.
+	struct SharedStage {
+		std::once_flag opened;
+		UsdStageRefPtr stage;
+		int pending = 0; // Pairs not yet reported, only touched by the main thread
+	};
+	std::map<std::string, std::unique_ptr<SharedStage>> m_stages;
+
+	// Pairs read and compared ahead of the one being reported, bounds the rigs held at once
+	static const size_t kPairsInFlightPerThread = 2;
+	ValidationLog::Buffer m_messages;
+};
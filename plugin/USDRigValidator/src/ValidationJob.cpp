@@ -0,0 +1,216 @@
+#include "ValidationJob.h"
+#include "RunArena.h"
+
+#include <chrono>
+#include <maya/MGlobal.h>
+#include <maya/MFnDagNode.h>
+#include <maya/MEventMessage.h>
+
+ValidationJob::ValidationJob(int id, const MDagPath& root, const MString& usdFilePath, int sampleLimit) :
+	m_id(id), m_root(root), m_usdFilePath(usdFilePath),
+	m_phase(Phase::JOINT_HIERARCHY), m_cursor(0), m_issues(sampleLimit),
+	m_state(State::RUNNING), m_cancelled(false), m_usdParsed(false),
+	m_idleCallbackId(0), m_hasIdleCallback(false)
+{
+}
+
+ValidationJob::~ValidationJob()
+{
+	m_cancelled = true;
+	removeIdleCallback();
+
+	if (m_usdFuture.valid()) m_usdFuture.wait();
+	if (m_compareFuture.valid()) m_compareFuture.wait();
+}
+
+MStatus ValidationJob::start()
+{
+	MStatus status;
+
+	m_mayaRig = std::make_unique<ValidateRigCmd::MayaRigData>();
+
+	// USD is thread safe, parse it while the main thread works through the Maya side
+	MString rootName = MFnDagNode(m_root).name();
+	m_usdFuture = std::async(std::launch::async, [this, rootName]() {
+		ValidationLog::ScopedThreadBuffer logScope(&m_messages);
+		auto usdRig = ValidateRigCmd::parseUSDRig(m_usdFilePath, rootName);
+		m_usdParsed = true;
+		return usdRig;
+	});
+
+	m_idleCallbackId = MEventMessage::addEventCallback("idle", onIdle, this, &status);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+	m_hasIdleCallback = true;
+
+	return MS::kSuccess;
+}
+
+void ValidationJob::cancel()
+{
+	m_cancelled = true;
+}
+
+double ValidationJob::progress() const
+{
+	State state = m_state.load();
+	if (state != State::RUNNING) return 1.0;
+
+	// USD parsing and Maya extraction overlap, the comparison comes last
+	double mayaFraction = 1.0;
+	switch (m_phase) {
+	case Phase::JOINT_HIERARCHY:
+		mayaFraction = 0.0;
+		break;
+	case Phase::JOINTS:
+		mayaFraction = 0.7 * m_cursor / std::max(1u, m_mayaRig->skeleton.jointPaths.length());
+		break;
+	case Phase::MESH_DISCOVERY:
+		mayaFraction = 0.7;
+		break;
+	case Phase::MESHES:
+		mayaFraction = 0.7 + 0.3 * m_cursor / std::max(1u, m_meshPaths.length());
+		break;
+	default:
+		break;
+	}
+
+	return 0.3 * (m_usdParsed ? 1.0 : 0.0) + 0.5 * mayaFraction;
+}
+
+void ValidationJob::flushMessages()
+{
+	m_messages.flush();
+}
+
+const char* ValidationJob::stateName(State state)
+{
+	switch (state) {
+	case State::RUNNING: return "running";
+	case State::DONE: return "done";
+	case State::CANCELLED: return "cancelled";
+	case State::FAILED: return "failed";
+	}
+	return "unknown";
+}
+
+void ValidationJob::advance()
+{
+	if (m_cancelled) {
+		finish(State::CANCELLED);
+		return;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kSliceMilliseconds);
+	while (m_phase < Phase::WAIT_FOR_USD && std::chrono::steady_clock::now() < deadline) {
+		if (stepMaya() != MS::kSuccess) {
+			finish(State::FAILED);
+			return;
+		}
+	}
+
+	if (m_phase == Phase::WAIT_FOR_USD && m_usdParsed) {
+		startCompare();
+	}
+}
+
+MStatus ValidationJob::stepMaya()
+{
+	MStatus status;
+	ValidateRigCmd::MayaSkeletonData& skel = m_mayaRig->skeleton;
+
+	switch (m_phase) {
+	case Phase::JOINT_HIERARCHY:
+		status = ValidateRigCmd::parseMayaJointHierarchy(m_root, skel);
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+		m_rootWorldInverse = m_root.inclusiveMatrix(&status).inverse();
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+		m_phase = Phase::JOINTS;
+		m_cursor = 0;
+		break;
+
+	case Phase::JOINTS:
+		if (m_cursor < skel.jointPaths.length()) {
+			status = ValidateRigCmd::parseMayaJoint(skel.jointPaths[m_cursor], m_rootWorldInverse,
+				skel.restTransforms[m_cursor], skel.bindTransforms[m_cursor]);
+			CHECK_MSTATUS_AND_RETURN_IT(status);
+			m_cursor++;
+		}
+		if (m_cursor == skel.jointPaths.length()) {
+			ValidateRigCmd::hashSubtrees(skel, TolerancePolicy::current(), skel.subtrees);
+			m_phase = Phase::MESH_DISCOVERY;
+		}
+		break;
+
+	case Phase::MESH_DISCOVERY:
+		m_meshPaths = ValidateRigCmd::findSkinnedMeshes(m_root);
+		m_influences = std::make_unique<InfluenceIndex>(skel);
+		m_phase = Phase::MESHES;
+		m_cursor = 0;
+		break;
+
+	case Phase::MESHES:
+		if (m_cursor < m_meshPaths.length()) {
+			auto skinData = ValidateRigCmd::parseMayaSkin(m_meshPaths[m_cursor], m_influences.get());
+			if (skinData) {
+				m_mayaRig->skinBindings.push_back(std::move(*skinData));
+				m_mayaRig->geomNames.append(ValidateRigCmd::geomName(m_meshPaths[m_cursor]));
+			}
+			m_cursor++;
+		}
+		if (m_cursor == m_meshPaths.length()) {
+			m_phase = Phase::WAIT_FOR_USD;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return MS::kSuccess;
+}
+
+void ValidationJob::startCompare()
+{
+	m_usdRig = m_usdFuture.get();
+	if (!m_usdRig) {
+		finish(State::FAILED);
+		return;
+	}
+
+	// Nothing left for the main thread, the comparison only reads the extracted data
+	m_phase = Phase::COMPARE;
+	removeIdleCallback();
+
+	m_compareFuture = std::async(std::launch::async, [this]() {
+		ValidationLog::ScopedThreadBuffer logScope(&m_messages);
+		RunArena arena;
+		RunArena::Scope arenaScope(arena);
+		if (m_cancelled) {
+			m_state = State::CANCELLED;
+			return;
+		}
+		ValidateRigCmd::validateRig(*m_usdRig, *m_mayaRig, m_issues);
+		m_state = m_cancelled ? State::CANCELLED : State::DONE;
+	});
+}
+
+void ValidationJob::finish(State state)
+{
+	removeIdleCallback();
+	m_state = state;
+}
+
+void ValidationJob::removeIdleCallback()
+{
+	if (m_hasIdleCallback) {
+		MMessage::removeCallback(m_idleCallbackId);
+		m_hasIdleCallback = false;
+	}
+}
+
+void ValidationJob::onIdle(void* clientData)
+{
+	ValidationJob* job = static_cast<ValidationJob*>(clientData);
+	job->flushMessages();
+	job->advance();
+}
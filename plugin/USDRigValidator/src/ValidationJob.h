@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+#include "ValidationLog.h"
+#include "ValidationReport.h"
+#include "InfluenceIndex.h"
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+#include <maya/MDagPath.h>
+#include <maya/MDagPathArray.h>
+#include <maya/MMatrix.h>
+#include <maya/MString.h>
+#include <maya/MMessage.h>
+
+// A validateRig -async run. The USD rig is parsed on a worker thread as soon as
+// the job starts, while the Maya side is extracted on the main thread in small
+// time slices from idle events so the UI stays responsive. Once both sides are
+// in, the comparison runs on a worker and the job is polled for its result.
+class ValidationJob
+{
+public:
+	typedef ValidateRigCmd::ValidationIssue ValidationIssue;
+
+	enum class State {
+		RUNNING,
+		DONE,
+		CANCELLED,
+		FAILED
+	};
+
+	ValidationJob(int id, const MDagPath& root, const MString& usdFilePath, int sampleLimit);
+	~ValidationJob();
+
+	MStatus start();
+	void cancel();
+
+	int id() const { return m_id; }
+	State state() const { return m_state.load(); }
+	double progress() const;
+
+	// Only valid once the job is DONE
+	const BoundedIssueSink& issues() const { return m_issues; }
+	const ValidateRigCmd::USDRigData* usdRig() const { return m_usdRig.get(); }
+	const ValidateRigCmd::MayaRigData* mayaRig() const { return m_mayaRig.get(); }
+
+	// Displays messages queued by the worker threads, main thread only
+	void flushMessages();
+
+	static const char* stateName(State state);
+
+private:
+	enum class Phase {
+		JOINT_HIERARCHY,
+		JOINTS,
+		MESH_DISCOVERY,
+		MESHES,
+		WAIT_FOR_USD,
+		COMPARE
+	};
+
+	// Main thread work done per idle event before yielding back to Maya
+	static const int kSliceMilliseconds = 10;
+
+	int m_id;
+	MDagPath m_root;
+	MString m_usdFilePath;
+
+	Phase m_phase;
+	unsigned int m_cursor;
+	MMatrix m_rootWorldInverse;
+	MDagPathArray m_meshPaths;
+	std::unique_ptr<InfluenceIndex> m_influences; // Over m_mayaRig->skeleton, built once the joints are read
+
+	std::unique_ptr<ValidateRigCmd::USDRigData> m_usdRig;
+	std::unique_ptr<ValidateRigCmd::MayaRigData> m_mayaRig;
+	BoundedIssueSink m_issues;
+
+	std::atomic<State> m_state;
+	std::atomic<bool> m_cancelled;
+	std::atomic<bool> m_usdParsed;
+
+	ValidationLog::Buffer m_messages;
+	MCallbackId m_idleCallbackId;
+	bool m_hasIdleCallback;
+
+	// Declared last so they are joined before the data the workers touch goes away
+	std::future<std::unique_ptr<ValidateRigCmd::USDRigData>> m_usdFuture;
+	std::future<void> m_compareFuture;
+
+	void advance();
+	MStatus stepMaya();
+	void startCompare();
+	void finish(State state);
+	void removeIdleCallback();
+
+	static void onIdle(void* clientData);
+};
@@ -0,0 +1,83 @@
+#include "ValidationLog.h"
+
+#include <maya/MGlobal.h>
+
+namespace ValidationLog {
+
+namespace {
+
+thread_local Buffer* t_buffer = nullptr;
+
+void display(Level level, const MString& message)
+{
+	switch (level) {
+	case Level::DISPLAY_INFO:
+		MGlobal::displayInfo(message);
+		break;
+	case Level::DISPLAY_WARNING:
+		MGlobal::displayWarning(message);
+		break;
+	case Level::DISPLAY_ERROR:
+		MGlobal::displayError(message);
+		break;
+	}
+}
+
+void log(Level level, const MString& message)
+{
+	if (t_buffer) {
+		t_buffer->append(level, message);
+	}
+	else {
+		display(level, message);
+	}
+}
+
+}
+
+void Buffer::append(Level level, const MString& message)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_messages.emplace_back(level, message);
+}
+
+void Buffer::flush()
+{
+	std::vector<std::pair<Level, MString>> messages;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		messages.swap(m_messages);
+	}
+
+	for (const auto& message : messages) {
+		display(message.first, message.second);
+	}
+}
+
+ScopedThreadBuffer::ScopedThreadBuffer(Buffer* buffer) :
+	m_previous(t_buffer)
+{
+	t_buffer = buffer;
+}
+
+ScopedThreadBuffer::~ScopedThreadBuffer()
+{
+	t_buffer = m_previous;
+}
+
+void info(const MString& message)
+{
+	log(Level::DISPLAY_INFO, message);
+}
+
+void warning(const MString& message)
+{
+	log(Level::DISPLAY_WARNING, message);
+}
+
+void error(const MString& message)
+{
+	log(Level::DISPLAY_ERROR, message);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <maya/MString.h>
+
+// MGlobal may only be used from the main thread. Code that also runs on worker
+// threads (USD parsing, comparisons) reports through ValidationLog instead: on a
+// thread with a Buffer installed the messages are queued, and the owner replays
+// them on the main thread with flush(). Everywhere else they go straight to MGlobal.
+namespace ValidationLog {
+
+enum class Level {
+	DISPLAY_INFO,
+	DISPLAY_WARNING,
+	DISPLAY_ERROR
+};
+
+class Buffer {
+public:
+	void append(Level level, const MString& message);
+
+	// Displays and clears the queued messages, main thread only
+	void flush();
+
+private:
+	std::mutex m_mutex;
+	std::vector<std::pair<Level, MString>> m_messages;
+};
+
+// Routes the current thread's messages into buffer for the lifetime of the scope
+class ScopedThreadBuffer {
+public:
+	explicit ScopedThreadBuffer(Buffer* buffer);
+	~ScopedThreadBuffer();
+
+private:
+	Buffer* m_previous;
+};
+
+void info(const MString& message);
+void warning(const MString& message);
+void error(const MString& message);
+
+}
\ No newline at end of file
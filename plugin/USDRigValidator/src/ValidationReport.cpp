@@ -0,0 +1,297 @@
+#include "ValidationReport.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace {
+
+// Round trips the value, JSON has no literal for NaN or infinity so those become null
+template <typename T>
+std::string jsonNumber(T value)
+{
+	if (!std::isfinite(value)) return "null";
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.*g", std::numeric_limits<T>::max_digits10, static_cast<double>(value));
+	return buffer;
+}
+
+// Escapes a string for use inside a JSON string literal
+std::string jsonEscape(const char* value)
+{
+	std::string escaped;
+	for (const char* c = value; *c; ++c) {
+		switch (*c) {
+		case '"': escaped += "\\\""; break;
+		case '\\': escaped += "\\\\"; break;
+		case '\n': escaped += "\\n"; break;
+		case '\r': escaped += "\\r"; break;
+		case '\t': escaped += "\\t"; break;
+		default:
+			if (static_cast<unsigned char>(*c) < 0x20) {
+				char buffer[8];
+				std::snprintf(buffer, sizeof(buffer), "\\u%04x", *c);
+				escaped += buffer;
+			}
+			else {
+				escaped += *c;
+			}
+		}
+	}
+	return escaped;
+}
+
+bool hasSuffix(const std::string& value, const std::string& suffix)
+{
+	return value.size() >= suffix.size() &&
+		value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}
+
+void IssueSink::merge(const BoundedIssueSink& issues)
+{
+	for (int t = 0; t < BoundedIssueSink::kNumCategories; ++t) {
+		const BoundedIssueSink::CategoryStats& stats = issues.category(static_cast<ValidationIssue::Type>(t));
+		for (const ValidationIssue& sample : stats.samples) {
+			add(sample);
+		}
+
+		uint64_t omitted = stats.count - stats.samples.size();
+		if (omitted > 0) {
+			add(ValidationIssue::makeRollUp(static_cast<ValidationIssue::Type>(t), stats.geomIndex,
+				static_cast<int>(omitted), stats.omittedErrorSum(), stats.maxError));
+		}
+	}
+}
+
+void BoundedIssueSink::add(const ValidationIssue& issue)
+{
+	CategoryStats& stats = m_categories[static_cast<int>(issue.type)];
+
+	if (stats.count == 0) {
+		stats.geomIndex = issue.geomIndex;
+	}
+	else if (stats.geomIndex != issue.geomIndex) {
+		stats.geomIndex = -1;
+	}
+
+	if (issue.rollUp) {
+		// Only the summary of the rolled up issues survived, so they stay out of the histogram
+		stats.count += issue.count;
+		stats.errorSum += issue.expected;
+		stats.maxError = std::max(stats.maxError, issue.diff);
+		return;
+	}
+
+	if (static_cast<int>(stats.samples.size()) < m_sampleLimit) {
+		stats.samples.push_back(issue);
+	}
+	stats.count++;
+	stats.errorSum += issue.diff;
+	stats.maxError = std::max(stats.maxError, issue.diff);
+	stats.histogram[histogramBin(issue.diff)]++;
+}
+
+void BoundedIssueSink::merge(const BoundedIssueSink& issues)
+{
+	for (int t = 0; t < kNumCategories; ++t) {
+		CategoryStats& stats = m_categories[t];
+		const CategoryStats& other = issues.m_categories[t];
+		if (other.count == 0) continue;
+
+		if (stats.count == 0) {
+			stats.geomIndex = other.geomIndex;
+		}
+		else if (stats.geomIndex != other.geomIndex) {
+			stats.geomIndex = -1;
+		}
+
+		for (size_t i = 0; i < other.samples.size() && static_cast<int>(stats.samples.size()) < m_sampleLimit; ++i) {
+			stats.samples.push_back(other.samples[i]);
+		}
+		stats.count += other.count;
+		stats.errorSum += other.errorSum;
+		stats.maxError = std::max(stats.maxError, other.maxError);
+		for (int b = 0; b < kHistogramBins; ++b) {
+			stats.histogram[b] += other.histogram[b];
+		}
+	}
+}
+
+uint64_t BoundedIssueSink::totalCount() const
+{
+	uint64_t total = 0;
+	for (const CategoryStats& stats : m_categories) {
+		total += stats.count;
+	}
+	return total;
+}
+
+int BoundedIssueSink::histogramBin(double diff)
+{
+	if (!(diff >= 1e-6)) return 0;
+	int bin = static_cast<int>(std::floor(std::log10(diff))) + 7;
+	return std::min(std::max(bin, 1), kHistogramBins - 1);
+}
+
+void BoundedIssueSink::serialize(std::string& out) const
+{
+	auto append = [&out](const void* data, size_t size) {
+		out.append(static_cast<const char*>(data), size);
+	};
+
+	for (const CategoryStats& stats : m_categories) {
+		uint32_t numSamples = static_cast<uint32_t>(stats.samples.size());
+		append(&stats.count, sizeof(stats.count));
+		append(&stats.maxError, sizeof(stats.maxError));
+		append(&stats.errorSum, sizeof(stats.errorSum));
+		append(stats.histogram, sizeof(stats.histogram));
+		append(&stats.geomIndex, sizeof(stats.geomIndex));
+		append(&numSamples, sizeof(numSamples));
+		append(stats.samples.data(), numSamples * sizeof(ValidationIssue));
+	}
+}
+
+bool BoundedIssueSink::deserialize(const std::string& in)
+{
+	size_t offset = 0;
+	auto read = [&in, &offset](void* data, size_t size) {
+		if (offset + size > in.size()) return false;
+		std::memcpy(data, in.data() + offset, size);
+		offset += size;
+		return true;
+	};
+
+	for (CategoryStats& stats : m_categories) {
+		uint32_t numSamples = 0;
+		if (!read(&stats.count, sizeof(stats.count)) ||
+			!read(&stats.maxError, sizeof(stats.maxError)) ||
+			!read(&stats.errorSum, sizeof(stats.errorSum)) ||
+			!read(stats.histogram, sizeof(stats.histogram)) ||
+			!read(&stats.geomIndex, sizeof(stats.geomIndex)) ||
+			!read(&numSamples, sizeof(numSamples)) ||
+			numSamples > static_cast<uint32_t>(m_sampleLimit)) {
+			return false;
+		}
+
+		stats.samples.assign(numSamples, ValidationIssue(ValidationIssue::Type::JOINT_COUNT_MISMATCH));
+		if (!read(stats.samples.data(), numSamples * sizeof(ValidationIssue))) return false;
+	}
+
+	return offset == in.size();
+}
+
+std::unique_ptr<ReportWriter> ReportWriter::create(const MString& path)
+{
+	std::string pathStr = path.asChar();
+
+	std::unique_ptr<ReportWriter> writer;
+	if (hasSuffix(pathStr, ".jsonl") || hasSuffix(pathStr, ".json")) {
+		writer = std::make_unique<JsonLinesReportWriter>();
+	}
+	else {
+		writer = std::make_unique<BinaryReportWriter>();
+	}
+
+	if (!writer->open(path)) return nullptr;
+	return writer;
+}
+
+bool JsonLinesReportWriter::open(const MString& path)
+{
+	m_file.open(path.asChar(), std::ios::out | std::ios::trunc);
+	return m_file.is_open();
+}
+
+void JsonLinesReportWriter::writeHeader(const MString& usdFilePath, const MString& rootName,
+	const MStringArray& geomNames)
+{
+	m_file << "{\"usdFile\":\"" << jsonEscape(usdFilePath.asUTF8())
+		<< "\",\"root\":\"" << jsonEscape(rootName.asUTF8())
+		<< "\",\"geoms\":[";
+	for (unsigned int i = 0; i < geomNames.length(); ++i) {
+		m_file << (i > 0 ? "," : "") << "\"" << jsonEscape(geomNames[i].asUTF8()) << "\"";
+	}
+	m_file << "]}\n";
+}
+
+void JsonLinesReportWriter::add(const ValidationIssue& issue)
+{
+	m_file << "{\"type\":\"" << ValidateRigCmd::issueTypeName(issue.type)
+		<< "\",\"index\":" << issue.index
+		<< ",\"geom\":" << issue.geomIndex
+		<< ",\"count\":" << issue.count
+		<< ",\"expected\":" << jsonNumber(issue.expected)
+		<< ",\"actual\":" << jsonNumber(issue.actual)
+		<< ",\"diff\":" << jsonNumber(issue.diff)
+		<< ",\"scaleDiff\":" << jsonNumber(issue.scaleDiff)
+		<< (issue.rollUp ? ",\"rollUp\":true}\n" : "}\n");
+	m_issueCount++;
+}
+
+bool JsonLinesReportWriter::close()
+{
+	m_file.close();
+	return !m_file.fail();
+}
+
+const char BinaryReportWriter::kMagic[4] = { 'R', 'V', 'R', '2' };
+
+bool BinaryReportWriter::open(const MString& path)
+{
+	m_file.open(path.asChar(), std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!m_file.is_open()) return false;
+
+	m_file.write(kMagic, sizeof(kMagic));
+	return true;
+}
+
+void BinaryReportWriter::writeHeader(const MString& usdFilePath, const MString& rootName,
+	const MStringArray& geomNames)
+{
+	BinaryIssueRecord record = {};
+	record.type = kHeaderRecordType;
+	record.count = static_cast<int32_t>(2 + geomNames.length());
+	m_file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+
+	writeString(usdFilePath);
+	writeString(rootName);
+	for (unsigned int i = 0; i < geomNames.length(); ++i) {
+		writeString(geomNames[i]);
+	}
+}
+
+void BinaryReportWriter::add(const ValidationIssue& issue)
+{
+	BinaryIssueRecord record = {};
+	record.type = static_cast<uint8_t>(issue.type);
+	record.rollUp = issue.rollUp ? 1 : 0;
+	record.index = issue.index;
+	record.geomIndex = issue.geomIndex;
+	record.count = issue.count;
+	record.expected = issue.expected;
+	record.actual = issue.actual;
+	record.diff = issue.diff;
+	record.scaleDiff = issue.scaleDiff;
+
+	m_file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	m_issueCount++;
+}
+
+bool BinaryReportWriter::close()
+{
+	m_file.close();
+	return !m_file.fail();
+}
+
+void BinaryReportWriter::writeString(const MString& value)
+{
+	const char* bytes = value.asUTF8();
+	uint32_t length = static_cast<uint32_t>(std::char_traits<char>::length(bytes));
+	m_file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+	m_file.write(bytes, length);
+}
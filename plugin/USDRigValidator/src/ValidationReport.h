@@ -0,0 +1,195 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <maya/MString.h>
+
+class BoundedIssueSink;
+
+// Receives issues as the validators find them
+class IssueSink
+{
+public:
+	typedef ValidateRigCmd::ValidationIssue ValidationIssue;
+
+	static const int kDefaultSampleLimit = 5;
+
+	virtual ~IssueSink() {}
+	virtual void add(const ValidationIssue& issue) = 0;
+
+	// Takes over issues a validator aggregated on its own, e.g. per worker. Sinks that
+	// keep individual issues get the samples plus one roll-up per category for the rest.
+	virtual void merge(const BoundedIssueSink& issues);
+
+	// Issues per category worth keeping individually, for validators that pre-aggregate
+	int sampleLimit() const { return m_sampleLimit; }
+	void setSampleLimit(int limit) { m_sampleLimit = limit; }
+
+protected:
+	int m_sampleLimit = kDefaultSampleLimit;
+};
+
+// Keeps every issue in memory, for callers that display or cache them
+class VectorIssueSink : public IssueSink
+{
+public:
+	explicit VectorIssueSink(std::vector<ValidationIssue>& issues) : m_issues(issues) {}
+
+	void add(const ValidationIssue& issue) override { m_issues.push_back(issue); }
+
+private:
+	std::vector<ValidationIssue>& m_issues;
+};
+
+// Keeps the first few issues of each category plus running statistics over all of them,
+// so its size does not depend on how many issues come in. Error statistics use diff.
+class BoundedIssueSink : public IssueSink
+{
+public:
+	// Decades of diff from 1e-6 to 1, plus one bin either side
+	static const int kHistogramBins = 8;
+	static const int kNumCategories = static_cast<int>(ValidationIssue::kLastType) + 1;
+	static_assert(static_cast<int>(ValidationIssue::kLastType) == static_cast<int>(ValidationIssue::Type::INVALID_SKIN_BINDING),
+		"A new issue type needs its own category, move kLastType and check the per category tables");
+
+	struct CategoryStats {
+		uint64_t count = 0;
+		double maxError = 0.0;
+		double errorSum = 0.0;
+		uint64_t histogram[kHistogramBins] = {};
+		int geomIndex = -1; // Shared by every issue of the category, or -1
+		std::vector<ValidationIssue> samples;
+
+		double meanError() const { return count > 0 ? errorSum / count : 0.0; }
+
+		// Error sum of the issues not kept as samples, what a roll-up carries
+		double omittedErrorSum() const {
+			double sum = errorSum;
+			for (const ValidationIssue& sample : samples) sum -= sample.diff;
+			return std::max(sum, 0.0);
+		}
+	};
+
+	explicit BoundedIssueSink(int sampleLimit = kDefaultSampleLimit) { m_sampleLimit = sampleLimit; }
+
+	void add(const ValidationIssue& issue) override;
+	void merge(const BoundedIssueSink& issues) override;
+
+	const CategoryStats& category(ValidationIssue::Type type) const {
+		return m_categories[static_cast<int>(type)];
+	}
+	uint64_t totalCount() const;
+	bool empty() const { return totalCount() == 0; }
+
+	static int histogramBin(double diff);
+
+	// Flat binary form for the result cache, read back into a sink with the same sample limit
+	void serialize(std::string& out) const;
+	bool deserialize(const std::string& in);
+
+private:
+	CategoryStats m_categories[kNumCategories];
+};
+
+// Feeds every issue to two sinks, e.g. a summary kept for display and a report file
+class TeeIssueSink : public IssueSink
+{
+public:
+	TeeIssueSink(IssueSink& first, IssueSink& second) : m_first(first), m_second(second) {
+		m_sampleLimit = second.sampleLimit();
+	}
+
+	void add(const ValidationIssue& issue) override {
+		m_first.add(issue);
+		m_second.add(issue);
+	}
+
+	void merge(const BoundedIssueSink& issues) override {
+		m_first.merge(issues);
+		m_second.merge(issues);
+	}
+
+private:
+	IssueSink& m_first;
+	IssueSink& m_second;
+};
+
+// Streams issues to a file as they arrive, so memory stays flat however many there are.
+// A header starts the issues of each validated pair, naming the pair and the skinned
+// meshes geomIndex refers to.
+class ReportWriter : public IssueSink
+{
+public:
+	// Picks the format from the extension: .jsonl/.json for JSON Lines, anything else binary
+	static std::unique_ptr<ReportWriter> create(const MString& path);
+
+	virtual ~ReportWriter() {}
+
+	virtual bool open(const MString& path) = 0;
+	virtual void writeHeader(const MString& usdFilePath, const MString& rootName,
+		const MStringArray& geomNames) = 0;
+	virtual bool close() = 0;
+
+	uint64_t issueCount() const { return m_issueCount; }
+
+protected:
+	uint64_t m_issueCount = 0;
+};
+
+// One JSON object per line: a header object per pair, then one object per issue
+class JsonLinesReportWriter : public ReportWriter
+{
+public:
+	bool open(const MString& path) override;
+	void writeHeader(const MString& usdFilePath, const MString& rootName,
+		const MStringArray& geomNames) override;
+	void add(const ValidationIssue& issue) override;
+	bool close() override;
+
+private:
+	std::ofstream m_file;
+};
+
+// Little endian binary report:
+//   char[4] magic "RVR2", RVR1 records have no scaleDiff
+//   then BinaryIssueRecords until the end of the file. A record whose type is
+//   kHeaderRecordType starts a pair, its count strings follow it, each a uint32 byte
+//   length and the UTF-8 bytes: USD file, root name, then the skinned mesh names.
+class BinaryReportWriter : public ReportWriter
+{
+public:
+	static const char kMagic[4];
+	static const uint8_t kHeaderRecordType = 0xff;
+
+#pragma pack(push, 1)
+	struct BinaryIssueRecord {
+		uint8_t type;
+		uint8_t rollUp;
+		uint8_t reserved[2];
+		int32_t index;
+		int32_t geomIndex;
+		int32_t count;
+		double expected;
+		double actual;
+		double diff;
+		float scaleDiff;
+	};
+#pragma pack(pop)
+
+	bool open(const MString& path) override;
+	void writeHeader(const MString& usdFilePath, const MString& rootName,
+		const MStringArray& geomNames) override;
+	void add(const ValidationIssue& issue) override;
+	bool close() override;
+
+private:
+	std::ofstream m_file;
+
+	void writeString(const MString& value);
+};
@@ -0,0 +1,346 @@
+#include "ValidationSession.h"
+
+#include <algorithm>
+#include <maya/MGlobal.h>
+#include <maya/MFnDagNode.h>
+#include <maya/MDGMessage.h>
+#include <maya/MMatrix.h>
+
+ValidationSession::ValidationSession(const MDagPath& root, const MString& usdFilePath) :
+	m_root(root), m_usdFilePath(usdFilePath),
+	m_sampleLimit(IssueSink::kDefaultSampleLimit), m_needsRebuild(true)
+{
+}
+
+ValidationSession::~ValidationSession()
+{
+	removeCallbacks();
+}
+
+bool ValidationSession::matches(const MDagPath& root, const MString& usdFilePath) const
+{
+	return m_root == root && m_usdFilePath == usdFilePath;
+}
+
+MStatus ValidationSession::revalidate(int sampleLimit)
+{
+	MStatus status;
+	int numJointsUpdated = 0;
+	int numSkinsUpdated = 0;
+
+	bool sampleLimitChanged = sampleLimit != m_sampleLimit;
+	m_sampleLimit = sampleLimit;
+
+	// Only the whole skeleton pass keeps more samples than a joint can produce
+	if (!m_needsRebuild && sampleLimitChanged && !m_skeletonIssues.empty()) {
+		validateSkeleton();
+	}
+
+	if (!m_needsRebuild) {
+		MMatrix rootWorldInverse = m_root.inclusiveMatrix(&status).inverse();
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+
+		// Rest transforms are root relative, so a dirty joint drags its whole subtree with it
+		int numJoints = static_cast<int>(m_jointDirty.size());
+		for (int i = 0; i < numJoints; ++i) {
+			if (!m_jointDirty[i]) continue;
+			std::fill(m_jointDirty.begin() + i, m_jointDirty.begin() + m_subtreeEnd[i], 1);
+		}
+
+		for (int i = 0; i < numJoints && !m_needsRebuild; ++i) {
+			if (!m_jointDirty[i]) continue;
+			status = updateJoint(i, rootWorldInverse);
+			CHECK_MSTATUS_AND_RETURN_IT(status);
+			numJointsUpdated++;
+		}
+
+		for (int i = 0; i < static_cast<int>(m_skinDirty.size()) && !m_needsRebuild; ++i) {
+			if (m_skinDirty[i]) {
+				status = updateSkin(i);
+				CHECK_MSTATUS_AND_RETURN_IT(status);
+				numSkinsUpdated++;
+			}
+			else if (sampleLimitChanged) {
+				// The extracted data is current, only the kept samples are not
+				validateSkin(i);
+			}
+		}
+	}
+
+	// Structural edits, or a dirty joint that turned out to be reparented, need a full pass
+	if (m_needsRebuild) {
+		status = rebuild();
+		CHECK_MSTATUS_AND_RETURN_IT(status);
+		numJointsUpdated = static_cast<int>(m_jointIssues.size());
+		numSkinsUpdated = static_cast<int>(m_skinIssues.size());
+	}
+
+	MString info;
+	info.format("Revalidated ^1s joint(s) and ^2s mesh(es)",
+		MString() + numJointsUpdated,
+		MString() + numSkinsUpdated);
+	MGlobal::displayInfo(info);
+
+	return MS::kSuccess;
+}
+
+void ValidationSession::collectIssues(IssueSink& issues) const
+{
+	issues.merge(m_skeletonIssues);
+	for (const BoundedIssueSink& jointIssues : m_jointIssues) {
+		issues.merge(jointIssues);
+	}
+	for (const BoundedIssueSink& skinIssues : m_skinIssues) {
+		issues.merge(skinIssues);
+	}
+}
+
+MStatus ValidationSession::rebuild()
+{
+	removeCallbacks();
+
+	m_usd = ValidateRigCmd::parseUSDRig(m_usdFilePath, MFnDagNode(m_root).name());
+	if (!m_usd) return MS::kFailure;
+
+	m_influences.reset();
+	m_maya = ValidateRigCmd::parseMayaRig(m_root);
+	if (!m_maya) return MS::kFailure;
+	m_influences = std::make_unique<InfluenceIndex>(m_maya->skeleton);
+
+	const ValidateRigCmd::MayaSkeletonData& mayaSkel = m_maya->skeleton;
+	int numJoints = static_cast<int>(mayaSkel.jointPaths.length());
+
+	// Joints come out of parseMayaSkel depth first, so every subtree is a contiguous range
+	m_subtreeEnd.resize(numJoints);
+	for (int i = 0; i < numJoints; ++i) {
+		m_subtreeEnd[i] = i + 1;
+	}
+	for (int i = numJoints - 1; i > 0; --i) {
+		int parent = mayaSkel.jointParentIndices[i];
+		if (parent >= 0) {
+			m_subtreeEnd[parent] = std::max(m_subtreeEnd[parent], m_subtreeEnd[i]);
+		}
+	}
+
+	validateSkeleton();
+
+	m_skinIssues.assign(m_maya->skinBindings.size(), BoundedIssueSink(m_sampleLimit));
+	for (size_t i = 0; i < m_maya->skinBindings.size(); ++i) {
+		validateSkin(static_cast<int>(i));
+	}
+
+	// Group the bound meshes by the skin cluster deforming them
+	m_skinClusters.clear();
+	for (size_t i = 0; i < m_maya->skinBindings.size(); ++i) {
+		const MObject& node = m_maya->skinBindings[i].skinClusterNode;
+
+		auto it = std::find_if(m_skinClusters.begin(), m_skinClusters.end(),
+			[&](const TrackedSkinCluster& tracked) { return tracked.node == node; });
+		if (it == m_skinClusters.end()) {
+			TrackedSkinCluster tracked;
+			tracked.node = node;
+
+			for (int joint : m_influences->influences(node).slotJoints) {
+				if (joint >= 0) {
+					tracked.jointIndices.push_back(joint);
+				}
+			}
+
+			m_skinClusters.push_back(tracked);
+			it = m_skinClusters.end() - 1;
+		}
+		it->skinIndices.push_back(static_cast<int>(i));
+	}
+
+	m_jointDirty.assign(numJoints, 0);
+	m_skinDirty.assign(m_maya->skinBindings.size(), 0);
+	m_needsRebuild = false;
+
+	registerCallbacks();
+
+	return MS::kSuccess;
+}
+
+MStatus ValidationSession::updateJoint(int jointIndex, const MMatrix& rootWorldInverse)
+{
+	ValidateRigCmd::MayaSkeletonData& mayaSkel = m_maya->skeleton;
+	const MDagPath& jointPath = mayaSkel.jointPaths[jointIndex];
+	m_jointDirty[jointIndex] = 0;
+
+	// A deleted or reparented joint changes the topology, leave it to a rebuild
+	int parentIndex = mayaSkel.jointParentIndices[jointIndex];
+	MDagPath parentPath = jointPath;
+	parentPath.pop();
+	if (!jointPath.isValid() ||
+		(parentIndex >= 0 && !(parentPath == mayaSkel.jointPaths[parentIndex]))) {
+		m_needsRebuild = true;
+		return MS::kSuccess;
+	}
+
+	MStatus status = ValidateRigCmd::parseMayaJoint(jointPath, rootWorldInverse,
+		mayaSkel.restTransforms[jointIndex], mayaSkel.bindTransforms[jointIndex]);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+	mayaSkel.subtrees.clear();
+
+	if (m_skeletonIssues.empty()) {
+		m_jointIssues[jointIndex] = BoundedIssueSink(kJointSampleLimit);
+		ValidateRigCmd::detailedValidateJoint(m_usd->skeleton, mayaSkel, jointIndex, m_jointIssues[jointIndex]);
+	}
+
+	return MS::kSuccess;
+}
+
+MStatus ValidationSession::updateSkin(int skinIndex)
+{
+	ValidateRigCmd::MayaSkinBindingData& mayaSkin = m_maya->skinBindings[skinIndex];
+	m_skinDirty[skinIndex] = 0;
+
+	// Its influences may have been edited, resolve them again
+	m_influences->forget(mayaSkin.skinClusterNode);
+	auto skinData = ValidateRigCmd::parseMayaSkin(mayaSkin.geomPath, mayaSkin.skinClusterNode, m_influences.get());
+	if (!skinData) {
+		m_needsRebuild = true;
+		return MS::kSuccess;
+	}
+
+	mayaSkin = std::move(*skinData);
+	validateSkin(skinIndex);
+
+	return MS::kSuccess;
+}
+
+void ValidationSession::validateSkeleton()
+{
+	const ValidateRigCmd::MayaSkeletonData& mayaSkel = m_maya->skeleton;
+	int numJoints = static_cast<int>(mayaSkel.jointPaths.length());
+
+	// Skeleton issues, per joint when the joint counts line up
+	m_skeletonIssues = BoundedIssueSink(m_sampleLimit);
+	m_jointIssues.assign(numJoints, BoundedIssueSink(kJointSampleLimit));
+	if (m_usd->skeleton.jointNames.size() == mayaSkel.jointNames.length()) {
+		for (int i = 0; i < numJoints; ++i) {
+			ValidateRigCmd::detailedValidateJoint(m_usd->skeleton, mayaSkel, i, m_jointIssues[i]);
+		}
+	}
+	else {
+		ValidateRigCmd::detailedValidateSkeleton(m_usd->skeleton, mayaSkel, m_skeletonIssues);
+	}
+}
+
+void ValidationSession::validateSkin(int skinIndex)
+{
+	m_skinIssues[skinIndex] = BoundedIssueSink(m_sampleLimit);
+	ValidateRigCmd::validateSkin(*m_usd, *m_maya, skinIndex, m_skinIssues[skinIndex]);
+}
+
+ValidationSession::CallbackContext* ValidationSession::newContext(int index)
+{
+	m_callbackContexts.push_back(std::make_unique<CallbackContext>(CallbackContext{ this, index }));
+	return m_callbackContexts.back().get();
+}
+
+void ValidationSession::registerCallbacks()
+{
+	MStatus status;
+
+	for (unsigned int i = 0; i < m_maya->skeleton.jointPaths.length(); ++i) {
+		MObject node = m_maya->skeleton.jointPaths[i].node();
+		MCallbackId id = MNodeMessage::addNodeDirtyPlugCallback(node, onJointDirty, newContext(i), &status);
+		if (status == MS::kSuccess) m_callbackIds.append(id);
+
+		// Names and parents are part of the interned joint ids and the parent indices
+		id = MNodeMessage::addNameChangedCallback(node, onJointRenamed, newContext(i), &status);
+		if (status == MS::kSuccess) m_callbackIds.append(id);
+		const MDagMessage::DagMessage parentMessages[] = { MDagMessage::kParentAdded, MDagMessage::kParentRemoved };
+		for (MDagMessage::DagMessage msg : parentMessages) {
+			id = MDagMessage::addDagCallback(m_maya->skeleton.jointPaths[i], msg, onJointReparented, newContext(i), &status);
+			if (status == MS::kSuccess) m_callbackIds.append(id);
+		}
+	}
+
+	for (size_t i = 0; i < m_skinClusters.size(); ++i) {
+		MObject node = m_skinClusters[i].node;
+		MCallbackId id = MNodeMessage::addAttributeChangedCallback(node, onSkinClusterChanged, newContext((int)i), &status);
+		if (status == MS::kSuccess) m_callbackIds.append(id);
+	}
+
+	for (size_t i = 0; i < m_maya->skinBindings.size(); ++i) {
+		MObject node = m_maya->skinBindings[i].geomPath.node();
+		MCallbackId id = MNodeMessage::addAttributeChangedCallback(node, onMeshChanged, newContext((int)i), &status);
+		if (status == MS::kSuccess) m_callbackIds.append(id);
+	}
+
+	// Joints or skin clusters coming and going invalidate the cached topology
+	const char* structuralTypes[] = { "joint", "skinCluster" };
+	for (const char* nodeType : structuralTypes) {
+		MCallbackId id = MDGMessage::addNodeAddedCallback(onStructureChanged, nodeType, newContext(-1), &status);
+		if (status == MS::kSuccess) m_callbackIds.append(id);
+		id = MDGMessage::addNodeRemovedCallback(onStructureChanged, nodeType, newContext(-1), &status);
+		if (status == MS::kSuccess) m_callbackIds.append(id);
+	}
+}
+
+void ValidationSession::removeCallbacks()
+{
+	for (unsigned int i = 0; i < m_callbackIds.length(); ++i) {
+		MMessage::removeCallback(m_callbackIds[i]);
+	}
+	m_callbackIds.clear();
+	m_callbackContexts.clear();
+}
+
+void ValidationSession::onJointDirty(MObject& node, MPlug& plug, void* clientData)
+{
+	CallbackContext* context = static_cast<CallbackContext*>(clientData);
+	context->session->m_jointDirty[context->index] = 1;
+}
+
+void ValidationSession::onSkinClusterChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void* clientData)
+{
+	const int relevant = MNodeMessage::kAttributeSet | MNodeMessage::kAttributeArrayAdded |
+		MNodeMessage::kAttributeArrayRemoved | MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken;
+	if (!(msg & relevant)) return;
+
+	CallbackContext* context = static_cast<CallbackContext*>(clientData);
+	ValidationSession* session = context->session;
+	const TrackedSkinCluster& tracked = session->m_skinClusters[context->index];
+
+	// bindPreMatrix feeds the joints' bind transforms, anything else the weights of the bound meshes
+	MString plugName = plug.partialName(false, false, false, false, false, true);
+	if (plugName.indexW("bindPreMatrix") == 0) {
+		for (int jointIndex : tracked.jointIndices) {
+			session->m_jointDirty[jointIndex] = 1;
+		}
+	}
+	else {
+		for (int skinIndex : tracked.skinIndices) {
+			session->m_skinDirty[skinIndex] = 1;
+		}
+	}
+}
+
+void ValidationSession::onMeshChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void* clientData)
+{
+	if (!(msg & (MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken))) return;
+
+	CallbackContext* context = static_cast<CallbackContext*>(clientData);
+	context->session->m_skinDirty[context->index] = 1;
+}
+
+void ValidationSession::onStructureChanged(MObject& node, void* clientData)
+{
+	CallbackContext* context = static_cast<CallbackContext*>(clientData);
+	context->session->m_needsRebuild = true;
+}
+
+void ValidationSession::onJointRenamed(MObject& node, const MString& previousName, void* clientData)
+{
+	CallbackContext* context = static_cast<CallbackContext*>(clientData);
+	context->session->m_needsRebuild = true;
+}
+
+void ValidationSession::onJointReparented(MDagPath& child, MDagPath& parent, void* clientData)
+{
+	CallbackContext* context = static_cast<CallbackContext*>(clientData);
+	context->session->m_needsRebuild = true;
+}
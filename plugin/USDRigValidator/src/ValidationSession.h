@@ -0,0 +1,96 @@
+#pragma once
+
+#include "ValidateRigCmd.h"
+#include "ValidationReport.h"
+#include "InfluenceIndex.h"
+
+#include <vector>
+#include <memory>
+#include <maya/MObject.h>
+#include <maya/MPlug.h>
+#include <maya/MDagPath.h>
+#include <maya/MMatrix.h>
+#include <maya/MString.h>
+#include <maya/MMessage.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MDagMessage.h>
+#include <maya/MCallbackIdArray.h>
+
+// Resident validation of one (Maya root, USD file) pair, kept alive between
+// validateRig -incremental calls. DG callbacks on the joints, skin clusters and
+// bound meshes record what an edit touched, and revalidate() re-extracts and
+// re-compares only those, reusing the cached USD and Maya data for the rest.
+class ValidationSession
+{
+public:
+	typedef ValidateRigCmd::ValidationIssue ValidationIssue;
+
+	ValidationSession(const MDagPath& root, const MString& usdFilePath);
+	~ValidationSession();
+
+	bool matches(const MDagPath& root, const MString& usdFilePath) const;
+
+	// Brings the cached rigs and issues up to date with the scene
+	MStatus revalidate(int sampleLimit);
+	void collectIssues(IssueSink& issues) const;
+
+	// The extracted rigs the issues index into, null until the first revalidate()
+	const ValidateRigCmd::USDRigData* usdRig() const { return m_usd.get(); }
+	const ValidateRigCmd::MayaRigData* mayaRig() const { return m_maya.get(); }
+
+private:
+	// What a callback was registered for, passed back as client data
+	struct CallbackContext {
+		ValidationSession* session;
+		int index;
+	};
+
+	struct TrackedSkinCluster {
+		MObject node;
+		std::vector<int> skinIndices;  // Entries of m_maya->skinBindings it deforms
+		std::vector<int> jointIndices; // Skeleton joints among its influences
+	};
+
+	MDagPath m_root;
+	MString m_usdFilePath;
+
+	std::unique_ptr<ValidateRigCmd::USDRigData> m_usd;
+	std::unique_ptr<ValidateRigCmd::MayaRigData> m_maya;
+	std::unique_ptr<InfluenceIndex> m_influences; // Over m_maya->skeleton
+
+	std::vector<int> m_subtreeEnd; // One past the last descendant of each joint, joints are in depth-first order
+	std::vector<TrackedSkinCluster> m_skinClusters;
+
+	// A joint check reports each category at most once, so one sample per category keeps
+	// all of a joint's issues while the counts and error sums stay mergeable
+	static const int kJointSampleLimit = 1;
+
+	BoundedIssueSink m_skeletonIssues;
+	std::vector<BoundedIssueSink> m_jointIssues;
+	std::vector<BoundedIssueSink> m_skinIssues;
+	int m_sampleLimit;
+
+	std::vector<char> m_jointDirty;
+	std::vector<char> m_skinDirty;
+	bool m_needsRebuild;
+
+	MCallbackIdArray m_callbackIds;
+	std::vector<std::unique_ptr<CallbackContext>> m_callbackContexts;
+
+	MStatus rebuild();
+	MStatus updateJoint(int jointIndex, const MMatrix& rootWorldInverse);
+	MStatus updateSkin(int skinIndex);
+	void validateSkeleton();
+	void validateSkin(int skinIndex);
+
+	void registerCallbacks();
+	void removeCallbacks();
+	CallbackContext* newContext(int index);
+
+	static void onJointDirty(MObject& node, MPlug& plug, void* clientData);
+	static void onSkinClusterChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void* clientData);
+	static void onMeshChanged(MNodeMessage::AttributeMessage msg, MPlug& plug, MPlug& otherPlug, void* clientData);
+	static void onStructureChanged(MObject& node, void* clientData);
+	static void onJointRenamed(MObject& node, const MString& previousName, void* clientData);
+	static void onJointReparented(MDagPath& child, MDagPath& parent, void* clientData);
+};
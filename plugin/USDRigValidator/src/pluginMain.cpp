@@ -1,3 +1,6 @@
+#include "ValidateRigCmd.h"
+#include "SceneCache.h"
+
 #include <maya/MFnPlugin.h>
 #include <maya/MGlobal.h>
 
@@ -8,6 +11,13 @@ MStatus initializePlugin(MObject obj)
 
 	MFnPlugin fnPlugin(obj, pluginVendor, pluginVersion);
 
+	MStatus status = fnPlugin.registerCommand(ValidateRigCmd::commandName,
+		ValidateRigCmd::creator, ValidateRigCmd::newSyntax);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+
+	// Scene topology is kept between validateRig calls until an edit invalidates it
+	SceneCache::create();
+
 	MGlobal::displayInfo("Plugin has been initialized!");
 
 	return (MS::kSuccess);
@@ -15,6 +25,15 @@ MStatus initializePlugin(MObject obj)
 
 MStatus uninitializePlugin(MObject obj)
 {
+	MFnPlugin fnPlugin(obj);
+
+	ValidateRigCmd::clearSession();
+	ValidateRigCmd::clearJobs();
+	SceneCache::destroy();
+
+	MStatus status = fnPlugin.deregisterCommand(ValidateRigCmd::commandName);
+	CHECK_MSTATUS_AND_RETURN_IT(status);
+
 	MGlobal::displayInfo("Plugin has been uninitialized!");
 
 	return (MS::kSuccess);
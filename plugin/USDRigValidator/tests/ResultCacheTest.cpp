@@ -0,0 +1,147 @@
+#include "TestCheck.h"
+#include "ResultCache.h"
+#include "ValidationReport.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+typedef ValidateRigCmd::ValidationIssue ValidationIssue;
+
+const std::string kKey = "0123456789abcdef";
+
+// More issues than the sample limit in one category, so roll-up statistics are stored too
+BoundedIssueSink makeIssues()
+{
+	BoundedIssueSink issues(2);
+	issues.add(ValidationIssue(ValidationIssue::Type::JOINT_COUNT_MISMATCH, -1, 12.0, 11.0));
+	for (int joint = 0; joint < 5; ++joint) {
+		issues.add(ValidationIssue(ValidationIssue::Type::BIND_TRANSFORM_MISMATCH, joint,
+			1.0, 1.0 + joint * 1e-3, joint * 1e-3));
+	}
+	issues.add(ValidationIssue(ValidationIssue::Type::WEIGHT_VALUE_MISMATCH, 17, 0.25, 0.5, 0.25, 3));
+	return issues;
+}
+
+bool sameIssue(const ValidationIssue& a, const ValidationIssue& b)
+{
+	return a.type == b.type && a.rollUp == b.rollUp && a.index == b.index && a.geomIndex == b.geomIndex &&
+		a.count == b.count && a.expected == b.expected && a.actual == b.actual && a.diff == b.diff &&
+		a.scaleDiff == b.scaleDiff;
+}
+
+bool sameIssues(const BoundedIssueSink& a, const BoundedIssueSink& b)
+{
+	if (a.totalCount() != b.totalCount()) return false;
+	for (int t = 0; t < BoundedIssueSink::kNumCategories; ++t) {
+		ValidationIssue::Type type = static_cast<ValidationIssue::Type>(t);
+		const BoundedIssueSink::CategoryStats& x = a.category(type);
+		const BoundedIssueSink::CategoryStats& y = b.category(type);
+		if (x.count != y.count || x.maxError != y.maxError || x.errorSum != y.errorSum ||
+			x.geomIndex != y.geomIndex || x.samples.size() != y.samples.size()) {
+			return false;
+		}
+		for (int bin = 0; bin < BoundedIssueSink::kHistogramBins; ++bin) {
+			if (x.histogram[bin] != y.histogram[bin]) return false;
+		}
+		for (size_t i = 0; i < x.samples.size(); ++i) {
+			if (!sameIssue(x.samples[i], y.samples[i])) return false;
+		}
+	}
+	return true;
+}
+
+std::string entryPath(const std::string& directory)
+{
+	return directory + "/" + kKey.substr(0, 2) + "/" + kKey + ".rvc";
+}
+
+void testRoundTrip(const std::string& directory)
+{
+	ResultCache cache(directory.c_str());
+	BoundedIssueSink stored = makeIssues();
+	CHECK(cache.store(kKey, stored));
+	CHECK(fs::exists(entryPath(directory)));
+
+	BoundedIssueSink loaded(2);
+	CHECK(cache.lookup(kKey, loaded));
+	CHECK(sameIssues(stored, loaded));
+
+	// An empty result is a result as well
+	BoundedIssueSink passed(2), loadedPassed(2);
+	CHECK(cache.store("fedcba9876543210", passed));
+	loadedPassed.add(ValidationIssue(ValidationIssue::Type::JOINT_COUNT_MISMATCH));
+	CHECK(cache.lookup("fedcba9876543210", loadedPassed));
+	CHECK(loadedPassed.empty());
+}
+
+void testMisses(const std::string& directory)
+{
+	ResultCache cache(directory.c_str());
+	BoundedIssueSink issues(2);
+	CHECK(!cache.lookup("00000000deadbeef", issues));
+	CHECK(!cache.lookup(std::string(), issues));
+	CHECK(!cache.store(std::string(), issues));
+	CHECK(issues.empty());
+}
+
+void testCorruptEntryIsAMiss(const std::string& directory)
+{
+	ResultCache cache(directory.c_str());
+	CHECK(cache.store(kKey, makeIssues()));
+
+	// Flip the last payload byte, the checksum no longer agrees
+	{
+		std::fstream file(entryPath(directory), std::ios::in | std::ios::out | std::ios::binary);
+		file.seekg(-1, std::ios::end);
+		char last = 0;
+		file.get(last);
+		file.seekp(-1, std::ios::end);
+		file.put(static_cast<char>(last ^ 0x5a));
+	}
+	BoundedIssueSink loaded(2);
+	CHECK(!cache.lookup(kKey, loaded));
+	CHECK(loaded.empty());
+
+	// Truncated by a writer that never got to rename its file into place
+	fs::resize_file(entryPath(directory), 6);
+	CHECK(!cache.lookup(kKey, loaded));
+}
+
+void testTrimEvictsOverBudget(const std::string& directory)
+{
+	// Room for about one entry, storing a few and trimming keeps the cache under budget
+	ResultCache cache(directory.c_str(), 512);
+	for (int i = 0; i < 8; ++i) {
+		std::string key = std::string("a") + std::to_string(i) + "00000000000000";
+		CHECK(cache.store(key, makeIssues()));
+	}
+	cache.trim();
+
+	uint64_t totalBytes = 0;
+	for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory)) {
+		if (entry.is_regular_file()) totalBytes += entry.file_size();
+	}
+	CHECK(totalBytes <= 512);
+}
+
+}
+
+int main()
+{
+	std::string root = (fs::temp_directory_path() / ("ResultCacheTest." + std::to_string(getpid()))).string();
+	fs::remove_all(root);
+
+	testRoundTrip(root + "/roundTrip");
+	testMisses(root + "/misses");
+	testCorruptEntryIsAMiss(root + "/corrupt");
+	testTrimEvictsOverBudget(root + "/trim");
+
+	fs::remove_all(root);
+	return TestCheck::testResult();
+}
@@ -0,0 +1,105 @@
+#include "TestCheck.h"
+#include "SkeletonMatcher.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef SkeletonMatcher::Signature Signature;
+typedef std::vector<std::pair<int, int>> Pairs;
+
+// Joints are numbered by name, depths count the joints on each level below the root
+Signature makeSignature(std::vector<int> jointIds, const std::vector<unsigned int>& depths,
+	const std::string& label = std::string())
+{
+	Signature signature;
+	std::sort(jointIds.begin(), jointIds.end());
+	signature.jointCount = static_cast<unsigned int>(jointIds.size());
+	signature.depthHistogram = depths;
+	signature.sortedJointIds = jointIds;
+	for (int id : jointIds) {
+		signature.nameHash = (signature.nameHash ^ static_cast<uint64_t>(id)) * 0x9e3779b97f4a7c15ull;
+	}
+	signature.label = label;
+	return signature;
+}
+
+Signature biped(const std::string& label = std::string())
+{
+	return makeSignature({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 }, { 1, 3, 3, 3 }, label);
+}
+
+void testUniqueBucketsPair()
+{
+	Pairs pairs = SkeletonMatcher::match({ biped() }, { biped() });
+	CHECK(pairs == Pairs({ { 0, 0 } }));
+}
+
+void testCloseSkeletonsPair()
+{
+	// One joint renamed and one added, well within the cutoff
+	Signature maya = makeSignature({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 11, 12 }, { 1, 3, 3, 4 });
+	CHECK(SkeletonMatcher::pairable(biped(), maya));
+	Pairs pairs = SkeletonMatcher::match({ biped() }, { maya });
+	CHECK(pairs == Pairs({ { 0, 0 } }));
+}
+
+void testUnrelatedSkeletonsStayUnmatched()
+{
+	// Same size and shape, no joint name in common
+	Signature prop = makeSignature({ 21, 22, 23, 24, 25, 26, 27, 28, 29, 30 }, { 1, 3, 3, 3 });
+	CHECK(!SkeletonMatcher::pairable(biped(), prop));
+	CHECK(SkeletonMatcher::match({ biped() }, { prop }).empty());
+	CHECK(SkeletonMatcher::match({ prop }, { biped() }).empty());
+}
+
+void testCutoffScalesWithJointCount()
+{
+	// The cutoff is half the joint count of the larger skeleton, 5 here. Each renamed joint
+	// counts twice, once per side.
+	Signature twoRenamed = makeSignature({ 1, 2, 3, 4, 5, 6, 7, 8, 11, 12 }, { 1, 3, 3, 3 });
+	Signature threeRenamed = makeSignature({ 1, 2, 3, 4, 5, 6, 7, 11, 12, 13 }, { 1, 3, 3, 3 });
+	CHECK(SkeletonMatcher::distance(biped(), twoRenamed) == 4.0);
+	CHECK(SkeletonMatcher::pairable(biped(), twoRenamed));
+	CHECK(SkeletonMatcher::distance(biped(), threeRenamed) == 6.0);
+	CHECK(!SkeletonMatcher::pairable(biped(), threeRenamed));
+}
+
+void testLeftoversDoNotTakeUnpairableCells()
+{
+	// Two copies of a USD skeleton compete for one Maya root, the other Maya root is
+	// unrelated. The copy that loses stays unmatched instead of taking the unrelated root.
+	Signature prop = makeSignature({ 21, 22, 23, 24, 25, 26, 27, 28, 29, 30 }, { 1, 3, 3, 3 });
+	Pairs pairs = SkeletonMatcher::match({ biped("hero"), biped("double") }, { biped("hero"), prop });
+	CHECK(pairs == Pairs({ { 0, 0 } }));
+}
+
+void testLabelsBreakTiesBetweenCopies()
+{
+	Pairs pairs = SkeletonMatcher::match({ biped("bob"), biped("alice") }, { biped("alice"), biped("bob") });
+	CHECK(pairs == Pairs({ { 0, 1 }, { 1, 0 } }));
+}
+
+void testMoreSkeletonsOnOneSide()
+{
+	Signature quadruped = makeSignature({ 31, 32, 33, 34, 35, 36, 37, 38 }, { 1, 4, 3 });
+	Pairs pairs = SkeletonMatcher::match({ biped(), quadruped }, { quadruped, biped(), biped("extra") });
+	CHECK(pairs == Pairs({ { 0, 1 }, { 1, 0 } }));
+}
+
+}
+
+int main()
+{
+	testUniqueBucketsPair();
+	testCloseSkeletonsPair();
+	testUnrelatedSkeletonsStayUnmatched();
+	testCutoffScalesWithJointCount();
+	testLeftoversDoNotTakeUnpairableCells();
+	testLabelsBreakTiesBetweenCopies();
+	testMoreSkeletonsOnOneSide();
+	return TestCheck::testResult();
+}
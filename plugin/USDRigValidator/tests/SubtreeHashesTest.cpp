@@ -0,0 +1,113 @@
+#include "TestCheck.h"
+#include "SubtreeHashes.h"
+
+#include <vector>
+
+namespace {
+
+const uint64_t kPolicyKey = 42;
+
+// root
+//   spine
+//     neck
+//   hip
+std::vector<int> depthFirstParents()
+{
+	return { -1, 0, 1, 0 };
+}
+
+std::vector<uint64_t> leaves()
+{
+	return { 11, 22, 33, 44 };
+}
+
+void testSubtreeEnds()
+{
+	SubtreeHashes hashes;
+	hashes.build(leaves(), depthFirstParents(), kPolicyKey);
+	CHECK(hashes.builtFor(kPolicyKey));
+	CHECK(!hashes.builtFor(kPolicyKey + 1));
+	CHECK(hashes.size() == 4);
+	CHECK(hashes.subtreeEnd(0) == 4);
+	CHECK(hashes.subtreeEnd(1) == 3);
+	CHECK(hashes.subtreeEnd(2) == 3);
+	CHECK(hashes.subtreeEnd(3) == 4);
+
+	// A leaf without children keeps its own hash
+	CHECK(hashes[2] == 33);
+	CHECK(hashes[3] == 44);
+}
+
+void testChangePropagatesToAncestorsOnly()
+{
+	SubtreeHashes before, after;
+	before.build(leaves(), depthFirstParents(), kPolicyKey);
+
+	std::vector<uint64_t> changed = leaves();
+	changed[2] = 34;
+	after.build(changed, depthFirstParents(), kPolicyKey);
+
+	CHECK(before[0] != after[0]);
+	CHECK(before[1] != after[1]);
+	CHECK(before[2] != after[2]);
+	CHECK(before[3] == after[3]);
+}
+
+void testSiblingOrderCounts()
+{
+	// root with two leaf children, swapped between the two builds
+	SubtreeHashes a, b;
+	a.build({ 1, 2, 3 }, { -1, 0, 0 }, kPolicyKey);
+	b.build({ 1, 3, 2 }, { -1, 0, 0 }, kPolicyKey);
+	CHECK(a[0] != b[0]);
+}
+
+void testOutOfOrderParentsAreRejected()
+{
+	// The child comes before its parent, its hash could not be folded in
+	SubtreeHashes hashes;
+	hashes.build({ 1, 2, 3 }, { -1, 2, 0 }, kPolicyKey);
+	CHECK(!hashes.builtFor(kPolicyKey));
+	CHECK(hashes.size() == 0);
+
+	// A joint listed as its own parent is out of order as well
+	hashes.build({ 1, 2 }, { -1, 1 }, kPolicyKey);
+	CHECK(!hashes.builtFor(kPolicyKey));
+}
+
+void testRebuildAfterRejection()
+{
+	SubtreeHashes hashes;
+	hashes.build({ 1, 2, 3 }, { -1, 2, 0 }, kPolicyKey);
+	hashes.build(leaves(), depthFirstParents(), kPolicyKey);
+	CHECK(hashes.builtFor(kPolicyKey));
+	CHECK(hashes.subtreeEnd(0) == 4);
+}
+
+void testSeveralRoots()
+{
+	// Two disjoint trees, neither folds into the other
+	SubtreeHashes hashes;
+	hashes.build({ 1, 2, 3, 4 }, { -1, 0, -1, 2 }, kPolicyKey);
+	CHECK(hashes.builtFor(kPolicyKey));
+	CHECK(hashes.subtreeEnd(0) == 2);
+	CHECK(hashes.subtreeEnd(2) == 4);
+
+	SubtreeHashes changed;
+	changed.build({ 1, 2, 3, 5 }, { -1, 0, -1, 2 }, kPolicyKey);
+	CHECK(hashes[0] == changed[0]);
+	CHECK(hashes[2] != changed[2]);
+}
+
+}
+
+int main()
+{
+	testSubtreeEnds();
+	testChangePropagatesToAncestorsOnly();
+	testSiblingOrderCounts();
+	testOutOfOrderParentsAreRejected();
+	testRebuildAfterRejection();
+	testSeveralRoots();
+	return TestCheck::testResult();
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the unit tests, which run without a test framework or a Maya session.
+// A test executable returns testResult() from main, non-zero when any check failed.
+namespace TestCheck {
+
+inline int& failures()
+{
+	static int s_failures = 0;
+	return s_failures;
+}
+
+inline void check(bool condition, const char* what, const char* file, int line)
+{
+	if (condition) return;
+	std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+	failures()++;
+}
+
+inline int testResult()
+{
+	if (failures() > 0) {
+		std::fprintf(stderr, "%d check(s) failed\n", failures());
+		return 1;
+	}
+	return 0;
+}
+
+}
+
+#define CHECK(condition) TestCheck::check((condition), #condition, __FILE__, __LINE__)
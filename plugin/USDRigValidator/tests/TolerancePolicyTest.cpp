@@ -0,0 +1,133 @@
+#include "TestCheck.h"
+#include "TolerancePolicy.h"
+
+#include <cmath>
+#include <random>
+
+namespace {
+
+void identity(double* m)
+{
+	for (int k = 0; k < 16; ++k) m[k] = (k % 5 == 0) ? 1.0 : 0.0;
+}
+
+// Equal proven keys have to mean a match, for any values and any policy
+void testEqualKeysMatch(const TolerancePolicy& policy, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+	std::uniform_int_distribution<int> exponent(-10, 7);
+	std::uniform_int_distribution<int> element(0, 15);
+	std::uniform_real_distribution<double> nudge(-2.0, 2.0);
+
+	int equalKeys = 0;
+	for (int trial = 0; trial < 20000; ++trial) {
+		double expected[16], actual[16];
+		for (int k = 0; k < 16; ++k) {
+			expected[k] = mantissa(random) * std::pow(10.0, exponent(random));
+			actual[k] = expected[k];
+		}
+
+		// One element moved by up to twice its bound, in either direction
+		int k = element(random);
+		actual[k] += nudge(random) * policy.allowance(k, expected[k]);
+
+		if (policy.provenHash(expected) == policy.provenHash(actual)) {
+			equalKeys++;
+			CHECK(policy.matches(expected, actual));
+		}
+	}
+
+	// Most nudges are within the bounds, some of them have to land in the same cells
+	CHECK(equalKeys > 0);
+}
+
+void testNearZeroSharesCell()
+{
+	TolerancePolicy policy;
+	double a[16], b[16];
+	identity(a);
+	identity(b);
+	b[1] = policy.linear.absolute * 0.4;
+	b[4] = -policy.linear.absolute * 0.4;
+	CHECK(policy.provenHash(a) == policy.provenHash(b));
+	CHECK(policy.matches(a, b));
+}
+
+void testBeyondBoundNeverSharesCell()
+{
+	TolerancePolicy policy;
+	double a[16], b[16];
+	identity(a);
+	a[12] = 12345.678;
+	for (int k = 0; k < 16; ++k) {
+		identity(b);
+		b[12] = a[12];
+		b[k] = a[k] + 3.0 * policy.allowance(k, a[k]);
+		CHECK(!policy.matches(a, b));
+		CHECK(policy.provenHash(a) != policy.provenHash(b));
+	}
+}
+
+void testBinadeIsPartOfTheCell()
+{
+	// Just either side of a power of two the relative bound halves, the two values must
+	// not share a cell sized for the larger binade
+	TolerancePolicy policy;
+	double a[16], b[16];
+	identity(a);
+	identity(b);
+	a[13] = std::nextafter(1024.0, 0.0);
+	b[13] = 1024.0;
+	CHECK(policy.matches(a, b));
+	uint64_t below = policy.provenHash(a);
+	uint64_t above = policy.provenHash(b);
+	CHECK(below != above);
+}
+
+void testUlpBounds()
+{
+	TolerancePolicy policy;
+	policy.linear = TolerancePolicy::Bounds();
+	policy.linear.ulps = 4;
+	testEqualKeysMatch(policy, 7);
+
+	double a[16], b[16];
+	identity(a);
+	identity(b);
+	b[0] = std::nextafter(1.0, 2.0);
+	CHECK(policy.matches(a, b));
+}
+
+void testNoBoundOnlyIdentical()
+{
+	TolerancePolicy policy;
+	policy.linear = TolerancePolicy::Bounds();
+	double a[16], b[16];
+	identity(a);
+	identity(b);
+	CHECK(policy.provenHash(a) == policy.provenHash(b));
+	b[5] = std::nextafter(1.0, 2.0);
+	CHECK(policy.provenHash(a) != policy.provenHash(b));
+}
+
+}
+
+int main()
+{
+	testEqualKeysMatch(TolerancePolicy(), 1);
+
+	TolerancePolicy loose;
+	loose.linear.absolute = 1e-3;
+	loose.linear.relative = 1e-4;
+	loose.translation.absolute = 1e-2;
+	loose.translation.relative = 1e-5;
+	testEqualKeysMatch(loose, 2);
+
+	testNearZeroSharesCell();
+	testBeyondBoundNeverSharesCell();
+	testBinadeIsPartOfTheCell();
+	testUlpBounds();
+	testNoBoundOnlyIdentical();
+	return TestCheck::testResult();
+}
@@ -0,0 +1,87 @@
+"""Worker process for rigValidatorFarm, run under mayapy.
+
+usage: mayapy rigValidatorWorker.py <queue dir> <USDRigValidator plugin> [result cache dir]
+
+Claims chunks from the queue until none are left. A chunk holds tab separated
+(Maya scene, USD file, root joint) lines; every run of lines for the same scene
+is validated with one validateRig -manifest call, writing one binary report.
+Any error exits non-zero so the orchestrator can retry the claimed chunk.
+With a result cache directory, pairs validated before by any worker are not
+validated again unless their USD layers or Maya rig changed.
+"""
+
+import os
+import sys
+
+
+def claimChunk(queueDir):
+    pendingDir = os.path.join(queueDir, 'pending')
+    claimedDir = os.path.join(queueDir, 'claimed')
+    for name in sorted(os.listdir(pendingDir)):
+        claimedPath = os.path.join(claimedDir, '%d.%s' % (os.getpid(), name))
+        try:
+            # Atomic, exactly one worker wins each chunk
+            os.rename(os.path.join(pendingDir, name), claimedPath)
+        except OSError:
+            continue
+        return name, claimedPath
+    return None, None
+
+
+def readSceneGroups(chunkPath):
+    groups = []
+    with open(chunkPath) as chunk:
+        for line in chunk:
+            fields = line.rstrip('\r\n').split('\t')
+            if len(fields) != 3:
+                raise ValueError('Expected scene, USD file and root in: %r' % line)
+            scene, usdFile, root = fields
+            if not groups or groups[-1][0] != scene:
+                groups.append((scene, []))
+            groups[-1][1].append((usdFile, root))
+    return groups
+
+
+def validateChunk(cmds, queueDir, name, claimedPath, resultCache):
+    reportsDir = os.path.join(queueDir, 'reports')
+    for index, (scene, pairs) in enumerate(readSceneGroups(claimedPath)):
+        cmds.file(scene, open=True, force=True)
+
+        # Not in claimed/, where recovery would mistake it for a chunk of this worker
+        manifestPath = os.path.join(queueDir, 'manifests', '%s.%03d.manifest' % (name, index))
+        with open(manifestPath, 'w') as manifest:
+            for usdFile, root in pairs:
+                manifest.write('%s %s\n' % (usdFile, root))
+
+        # Renamed once complete so a crash never leaves a truncated report behind
+        reportPath = os.path.join(reportsDir, '%s.%03d.rvr' % (name, index))
+        flags = {'manifest': manifestPath, 'report': reportPath + '.tmp'}
+        if resultCache:
+            flags['resultCache'] = resultCache
+        cmds.validateRig(**flags)
+        os.rename(reportPath + '.tmp', reportPath)
+        os.remove(manifestPath)
+
+    os.rename(claimedPath, os.path.join(queueDir, 'done', name))
+
+
+def main(queueDir, pluginPath, resultCache=None):
+    import maya.standalone
+    maya.standalone.initialize(name='python')
+    from maya import cmds
+
+    cmds.loadPlugin(pluginPath)
+    while True:
+        name, claimedPath = claimChunk(queueDir)
+        if name is None:
+            break
+        validateChunk(cmds, queueDir, name, claimedPath, resultCache)
+
+    maya.standalone.uninitialize()
+
+
+if __name__ == '__main__':
+    if len(sys.argv) not in (3, 4):
+        sys.stderr.write(__doc__)
+        sys.exit(2)
+    main(*sys.argv[1:])
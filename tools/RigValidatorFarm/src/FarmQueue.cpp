@@ -0,0 +1,147 @@
+#include "FarmQueue.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+FarmQueue::FarmQueue(const std::string& root) :
+	m_root(root)
+{
+}
+
+bool FarmQueue::create()
+{
+	std::error_code error;
+	for (const char* name : { "pending", "claimed", "done", "failed", "reports", "manifests" }) {
+		fs::remove_all(dir(name), error);
+		if (!fs::create_directories(dir(name), error)) {
+			std::fprintf(stderr, "Could not create %s: %s\n", dir(name).c_str(), error.message().c_str());
+			return false;
+		}
+	}
+	m_attempts.clear();
+	return true;
+}
+
+bool FarmQueue::enqueue(const std::vector<std::string>& lines, size_t chunkSize)
+{
+	chunkSize = std::max<size_t>(chunkSize, 1);
+
+	for (size_t begin = 0, chunk = 0; begin < lines.size(); begin += chunkSize, ++chunk) {
+		// Zero padded so that sorting by name keeps the asset list order
+		char name[32];
+		std::snprintf(name, sizeof(name), "chunk-%06zu", chunk);
+
+		// Written next to the queue first so a worker never claims a partial chunk
+		std::string tmpPath = dir("claimed") + "/" + name + ".tmp";
+		{
+			std::ofstream file(tmpPath);
+			size_t end = std::min(begin + chunkSize, lines.size());
+			for (size_t i = begin; i < end; ++i) {
+				file << lines[i] << "\n";
+			}
+			if (!file) {
+				std::fprintf(stderr, "Could not write chunk %s\n", tmpPath.c_str());
+				return false;
+			}
+		}
+
+		std::error_code error;
+		fs::rename(tmpPath, dir("pending") + "/" + name, error);
+		if (error) {
+			std::fprintf(stderr, "Could not enqueue %s: %s\n", name, error.message().c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int FarmQueue::recover(pid_t pid, int maxRetries)
+{
+	std::string prefix = std::to_string(pid) + ".";
+	int numRecovered = 0;
+
+	std::error_code error;
+	for (const fs::directory_entry& entry : fs::directory_iterator(dir("claimed"), error)) {
+		std::string fileName = entry.path().filename().string();
+		if (fileName.compare(0, prefix.size(), prefix) != 0) continue;
+
+		std::string chunk = fileName.substr(prefix.size());
+		int attempts = ++m_attempts[chunk];
+		const char* target = attempts > maxRetries ? "failed" : "pending";
+
+		std::error_code renameError;
+		fs::rename(entry.path(), dir(target) + "/" + chunk, renameError);
+		if (renameError) {
+			std::fprintf(stderr, "Could not recover %s: %s\n", chunk.c_str(), renameError.message().c_str());
+			continue;
+		}
+
+		std::fprintf(stderr, "Worker %d died on %s, %s\n", (int)pid, chunk.c_str(),
+			attempts > maxRetries ? "giving up" : "retrying");
+		numRecovered++;
+	}
+
+	return numRecovered;
+}
+
+size_t FarmQueue::numPending() const
+{
+	return countFiles("pending");
+}
+
+size_t FarmQueue::numDone() const
+{
+	return countFiles("done");
+}
+
+size_t FarmQueue::numFailed() const
+{
+	return countFiles("failed");
+}
+
+std::vector<std::string> FarmQueue::reports() const
+{
+	std::vector<std::string> reports;
+
+	std::set<std::string> doneChunks;
+	std::error_code error;
+	for (const fs::directory_entry& entry : fs::directory_iterator(dir("done"), error)) {
+		doneChunks.insert(entry.path().filename().string());
+	}
+
+	for (const fs::directory_entry& entry : fs::directory_iterator(dir("reports"), error)) {
+		// Reports still being written end in .tmp, the others are named <chunk>.<n>.rvr
+		if (entry.path().extension() != ".rvr") continue;
+		std::string chunk = entry.path().stem().stem().string();
+		if (doneChunks.count(chunk)) {
+			reports.push_back(entry.path().string());
+		}
+	}
+
+	std::sort(reports.begin(), reports.end());
+	return reports;
+}
+
+std::string FarmQueue::dir(const char* name) const
+{
+	return m_root + "/" + name;
+}
+
+size_t FarmQueue::countFiles(const char* name) const
+{
+	size_t count = 0;
+
+	std::error_code error;
+	for (const fs::directory_entry& entry : fs::directory_iterator(dir(name), error)) {
+		if (entry.is_regular_file()) count++;
+	}
+
+	return count;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// File based work queue shared by the orchestrator and its worker processes.
+// Chunks of the asset list are files; a worker claims one by renaming it from
+// pending/ to claimed/<pid>.<chunk>, which is atomic, so idle workers keep
+// stealing whatever is left without any coordination. A finished chunk moves
+// to done/, and the chunks of a worker that died are put back in pending/.
+//
+//   <root>/pending/   chunks nobody has claimed yet
+//   <root>/claimed/   chunks being validated, prefixed with the worker pid
+//   <root>/done/      validated chunks
+//   <root>/failed/    chunks that crashed their worker too many times
+//   <root>/reports/   binary reports, <chunk>.<n>.rvr
+//   <root>/manifests/ validateRig manifests of the chunks being validated, kept
+//                     out of claimed/ so they are never recovered as chunks
+class FarmQueue
+{
+public:
+	explicit FarmQueue(const std::string& root);
+
+	// Creates the directories, clearing what a previous run left behind
+	bool create();
+
+	// Splits lines into chunks of chunkSize and enqueues them
+	bool enqueue(const std::vector<std::string>& lines, size_t chunkSize);
+
+	// Puts the chunks claimed by a worker that exited back in pending/, or in
+	// failed/ once they have been tried more than maxRetries times. Returns the
+	// number of chunks the worker was holding.
+	int recover(pid_t pid, int maxRetries);
+
+	size_t numPending() const;
+	size_t numDone() const;
+	size_t numFailed() const;
+
+	// Report files of the chunks in done/, in chunk order. A chunk that failed or never
+	// ran may have left the reports of the scenes it got through, those are not returned.
+	std::vector<std::string> reports() const;
+
+	const std::string& root() const { return m_root; }
+
+private:
+	std::string m_root;
+	std::map<std::string, int> m_attempts; // Failed attempts per chunk
+
+	std::string dir(const char* name) const;
+	size_t countFiles(const char* name) const;
+};
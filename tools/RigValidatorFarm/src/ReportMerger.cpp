@@ -0,0 +1,44 @@
+#include "ReportMerger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+const char ReportMerger::kMagic[4] = { 'R', 'V', 'R', '2' };
+
+int ReportMerger::merge(const std::vector<std::string>& shardPaths, const std::string& outputPath)
+{
+	std::ofstream output(outputPath, std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!output.is_open()) {
+		std::fprintf(stderr, "Could not open %s\n", outputPath.c_str());
+		return -1;
+	}
+	output.write(kMagic, sizeof(kMagic));
+
+	int numMerged = 0;
+	bool rejected = false;
+	char buffer[1 << 16];
+	for (const std::string& shardPath : shardPaths) {
+		std::ifstream shard(shardPath, std::ios::in | std::ios::binary);
+
+		char magic[sizeof(kMagic)];
+		if (!shard.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+			std::fprintf(stderr, "%s is not a validation report in the %.4s format\n", shardPath.c_str(), kMagic);
+			rejected = true;
+			continue;
+		}
+
+		while (shard.read(buffer, sizeof(buffer)) || shard.gcount() > 0) {
+			output.write(buffer, shard.gcount());
+		}
+		numMerged++;
+	}
+
+	output.close();
+	if (output.fail()) {
+		std::fprintf(stderr, "Failed writing %s\n", outputPath.c_str());
+		return -1;
+	}
+
+	return rejected ? -1 : numMerged;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Concatenates the binary reports written by validateRig -report into one file.
+// A report is the "RVR2" magic followed by a stream of records in which every
+// validated pair starts with its own header record (see BinaryReportWriter in
+// the plugin), so merging keeps one magic and appends the rest of each shard.
+// Records of other versions differ in size and cannot be mixed into one file.
+class ReportMerger
+{
+public:
+	static const char kMagic[4];
+
+	// Returns the number of shards merged, or -1 if the output could not be written or
+	// a shard is not a report in this format. Such shards are left out of the output.
+	static int merge(const std::vector<std::string>& shardPaths, const std::string& outputPath);
+};
@@ -0,0 +1,214 @@
+// rigValidatorFarm: validates a whole asset library on one machine by sharding it
+// across headless mayapy workers, each running validateRig -manifest on the chunks
+// it claims from a FarmQueue, then merging their binary reports.
+//
+// The asset list has one pair per line, tab separated: Maya scene, USD file, root joint.
+// Lines for the same scene should be adjacent, a worker opens each scene once per chunk.
+
+#include "FarmQueue.h"
+#include "ReportMerger.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+	std::string assetList;
+	std::string outputPath;
+	std::string pluginPath;
+	std::string mayapy = "mayapy";
+	std::string workerScript;
+	std::string workDir;
+	std::string resultCache;
+	int numWorkers = 4;
+	int chunkSize = 8;
+	int maxRetries = 2;
+};
+
+void printUsage()
+{
+	std::fprintf(stderr,
+		"usage: rigValidatorFarm -assets <list> -out <report.rvr> -plugin <USDRigValidator plugin>\n"
+		"                        [-workers 4] [-chunk 8] [-retries 2] [-mayapy mayapy]\n"
+		"                        [-worker rigValidatorWorker.py] [-work <out>.farm]\n"
+		"                        [-cache <validateRig -resultCache directory>]\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; ++i) {
+		std::string flag = argv[i];
+		if (i + 1 >= argc) {
+			std::fprintf(stderr, "Missing value for %s\n", flag.c_str());
+			return false;
+		}
+		const char* value = argv[++i];
+
+		if (flag == "-assets") options.assetList = value;
+		else if (flag == "-out") options.outputPath = value;
+		else if (flag == "-plugin") options.pluginPath = value;
+		else if (flag == "-mayapy") options.mayapy = value;
+		else if (flag == "-worker") options.workerScript = value;
+		else if (flag == "-work") options.workDir = value;
+		else if (flag == "-cache") options.resultCache = value;
+		else if (flag == "-workers") options.numWorkers = std::atoi(value);
+		else if (flag == "-chunk") options.chunkSize = std::atoi(value);
+		else if (flag == "-retries") options.maxRetries = std::atoi(value);
+		else {
+			std::fprintf(stderr, "Unknown flag %s\n", flag.c_str());
+			return false;
+		}
+	}
+
+	if (options.assetList.empty() || options.outputPath.empty() || options.pluginPath.empty()) {
+		return false;
+	}
+	if (options.numWorkers < 1 || options.chunkSize < 1 || options.maxRetries < 0) {
+		std::fprintf(stderr, "-workers and -chunk must be positive, -retries cannot be negative\n");
+		return false;
+	}
+
+	// The worker script ships next to the executable
+	if (options.workerScript.empty()) {
+		options.workerScript = (std::filesystem::path(argv[0]).parent_path() / "rigValidatorWorker.py").string();
+	}
+	if (options.workDir.empty()) {
+		options.workDir = options.outputPath + ".farm";
+	}
+
+	return true;
+}
+
+bool readAssetList(const std::string& path, std::vector<std::string>& lines)
+{
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		std::fprintf(stderr, "Could not open asset list %s\n", path.c_str());
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(file, line)) {
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		if (line.empty() || line[0] == '#') continue;
+		lines.push_back(line);
+	}
+	return true;
+}
+
+pid_t spawnWorker(const Options& options, const FarmQueue& queue)
+{
+	pid_t pid = fork();
+	if (pid != 0) return pid;
+
+	// Child
+	std::vector<char*> args = {
+		const_cast<char*>(options.mayapy.c_str()),
+		const_cast<char*>(options.workerScript.c_str()),
+		const_cast<char*>(queue.root().c_str()),
+		const_cast<char*>(options.pluginPath.c_str())
+	};
+	if (!options.resultCache.empty()) {
+		args.push_back(const_cast<char*>(options.resultCache.c_str()));
+	}
+	args.push_back(nullptr);
+	execvp(args[0], args.data());
+	std::fprintf(stderr, "Could not start %s: %s\n", args[0], std::strerror(errno));
+	_exit(127);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage();
+		return 2;
+	}
+
+	std::vector<std::string> lines;
+	if (!readAssetList(options.assetList, lines)) return 2;
+
+	FarmQueue queue(options.workDir);
+	if (!queue.create() || !queue.enqueue(lines, options.chunkSize)) return 1;
+
+	size_t numChunks = queue.numPending();
+	std::printf("Validating %zu pair(s) in %zu chunk(s) with %d worker(s)\n",
+		lines.size(), numChunks, options.numWorkers);
+
+	std::set<pid_t> workers;
+	for (int i = 0; i < options.numWorkers && i < (int)numChunks; ++i) {
+		pid_t pid = spawnWorker(options, queue);
+		if (pid < 0) {
+			std::perror("fork");
+			break;
+		}
+		workers.insert(pid);
+	}
+
+	// Workers that die before claiming anything cannot be fixed by retrying forever,
+	// usually mayapy or the plugin is missing
+	int numStartupFailures = 0;
+	const int maxStartupFailures = options.numWorkers * (options.maxRetries + 1);
+
+	while (!workers.empty()) {
+		int status = 0;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (pid < 0) {
+			if (errno == EINTR) continue;
+			std::perror("waitpid");
+			break;
+		}
+		if (workers.erase(pid) == 0) continue;
+
+		bool succeeded = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		int numRecovered = queue.recover(pid, options.maxRetries);
+		if (!succeeded && numRecovered == 0) {
+			numStartupFailures++;
+		}
+
+		if (!succeeded) {
+			if (WIFSIGNALED(status)) {
+				std::fprintf(stderr, "Worker %d killed by signal %d\n", (int)pid, WTERMSIG(status));
+			}
+			else {
+				std::fprintf(stderr, "Worker %d exited with %d\n", (int)pid, WEXITSTATUS(status));
+			}
+		}
+
+		// Replace lost workers while there is work left for them to steal. A worker that
+		// exits cleanly found the queue empty, unless a crashed chunk came back since.
+		bool moreWork = queue.numPending() > 0;
+		if (moreWork && (!succeeded || workers.empty()) && numStartupFailures < maxStartupFailures) {
+			pid_t replacement = spawnWorker(options, queue);
+			if (replacement > 0) workers.insert(replacement);
+		}
+	}
+
+	size_t numPending = queue.numPending();
+	size_t numFailed = queue.numFailed();
+	if (numPending > 0) {
+		std::fprintf(stderr, "Workers kept failing to start, %zu chunk(s) never ran\n", numPending);
+	}
+
+	std::vector<std::string> reports = queue.reports();
+	int numMerged = ReportMerger::merge(reports, options.outputPath);
+	if (numMerged < 0) return 1;
+
+	std::printf("%zu of %zu chunk(s) validated, %zu failed, %d report(s) merged into %s\n",
+		queue.numDone(), numChunks, numFailed, numMerged, options.outputPath.c_str());
+
+	return numPending == 0 && numFailed == 0 ? 0 : 1;
+}
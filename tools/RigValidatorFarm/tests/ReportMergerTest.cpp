@@ -0,0 +1,95 @@
+#include "ReportMerger.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int s_failures = 0;
+
+void check(bool condition, const char* what, int line)
+{
+	if (condition) return;
+	std::fprintf(stderr, "ReportMergerTest.cpp:%d: check failed: %s\n", line, what);
+	s_failures++;
+}
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+void writeFile(const std::string& path, const std::string& contents)
+{
+	std::ofstream file(path, std::ios::out | std::ios::trunc | std::ios::binary);
+	file.write(contents.data(), contents.size());
+}
+
+std::string readFile(const std::string& path)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void testMergesCurrentFormat(const std::string& dir)
+{
+	writeFile(dir + "/a.rvr", std::string("RVR2") + "first");
+	writeFile(dir + "/b.rvr", std::string("RVR2") + "second");
+	writeFile(dir + "/empty.rvr", "RVR2");
+
+	int numMerged = ReportMerger::merge({ dir + "/a.rvr", dir + "/empty.rvr", dir + "/b.rvr" }, dir + "/out.rvr");
+	CHECK(numMerged == 3);
+	CHECK(readFile(dir + "/out.rvr") == "RVR2firstsecond");
+}
+
+void testRejectsOtherMagics(const std::string& dir)
+{
+	// An older version, a file that is not a report and one too short to hold a magic
+	writeFile(dir + "/good.rvr", std::string("RVR2") + "kept");
+	writeFile(dir + "/old.rvr", std::string("RVR1") + "stale");
+	writeFile(dir + "/text.rvr", "not a report");
+	writeFile(dir + "/short.rvr", "RV");
+
+	for (const char* bad : { "/old.rvr", "/text.rvr", "/short.rvr", "/missing.rvr" }) {
+		int numMerged = ReportMerger::merge({ dir + "/good.rvr", dir + bad }, dir + "/out.rvr");
+		CHECK(numMerged == -1);
+
+		// The shards that are reports still make it into the output
+		CHECK(readFile(dir + "/out.rvr") == "RVR2kept");
+	}
+}
+
+void testNoShards(const std::string& dir)
+{
+	CHECK(ReportMerger::merge({}, dir + "/out.rvr") == 0);
+	CHECK(readFile(dir + "/out.rvr") == "RVR2");
+}
+
+void testUnwritableOutput(const std::string& dir)
+{
+	CHECK(ReportMerger::merge({}, dir + "/no/such/directory/out.rvr") == -1);
+}
+
+}
+
+int main()
+{
+	std::string dir = (fs::temp_directory_path() / ("ReportMergerTest." + std::to_string(getpid()))).string();
+	fs::create_directories(dir);
+
+	testMergesCurrentFormat(dir);
+	testRejectsOtherMagics(dir);
+	testNoShards(dir);
+	testUnwritableOutput(dir);
+
+	fs::remove_all(dir);
+	if (s_failures > 0) {
+		std::fprintf(stderr, "%d check(s) failed\n", s_failures);
+		return 1;
+	}
+	return 0;
+}